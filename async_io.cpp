@@ -0,0 +1,851 @@
+#include <brt/async_io.hpp>
+#include <brt/err.hpp>
+#include <brt/small_vec.hpp>
+#include <brt/sync.hpp>
+#include <brt/utils.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(BRT_OS_WINDOWS)
+#include <windows.h>
+#endif
+
+#if defined(BRT_OS_LINUX)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace brt {
+
+struct FileLoadRequest {
+    const char *path;
+    char *dst;
+    i64 dstCapacity;
+    StackAlloc *arena;
+    u64 alignment;
+    u64 userData;
+};
+
+struct AsyncFileLoader::Impl {
+    virtual ~Impl() = default;
+
+    virtual void submit(const FileLoadRequest &req) = 0;
+    virtual i64 reap(Span<FileLoadCompletion> out, i64 min_completions) = 0;
+    virtual i64 numOutstanding() const = 0;
+    virtual FileLoadBackend backend() const = 0;
+};
+
+namespace {
+
+// Read requests are split so lengths fit the 32 bit read size of every
+// backend
+constexpr i64 max_read_bytes = 1 << 30;
+
+// Returns nullptr and sets *error if the file can't be stored
+char * loadDestination(const FileLoadRequest &req, i64 num_bytes, i32 *error)
+{
+    if (req.arena != nullptr) {
+        return (char *)req.arena->alloc((u64)num_bytes, req.alignment);
+    }
+
+    if (num_bytes > req.dstCapacity) {
+        *error = ENOBUFS;
+        return nullptr;
+    }
+
+    return req.dst;
+}
+
+// FIFO of plain structs that is compacted whenever it drains
+template <typename T>
+class Queue {
+public:
+    inline void push(const T &v) { items_.push(v); }
+    inline i64 size() const { return items_.size() - head_; }
+
+    inline T pop()
+    {
+        T v = items_[head_++];
+        if (head_ == items_.size()) {
+            items_.clear();
+            head_ = 0;
+        }
+
+        return v;
+    }
+
+private:
+    SmallVec<T, 64> items_ {};
+    i64 head_ = 0;
+};
+
+// Blocking load used by the thread pool. arena_lock guards allocation
+// from req.arena, which is shared between workers.
+FileLoadCompletion loadBlocking(const FileLoadRequest &req,
+                                std::mutex &arena_lock)
+{
+    FileLoadCompletion result {
+        .userData = req.userData,
+        .data = nullptr,
+        .numBytes = 0,
+        .error = 0,
+    };
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    int fd = ::open(req.path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        result.error = errno;
+        return result;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        result.error = errno;
+        ::close(fd);
+        return result;
+    }
+
+    i64 num_bytes = (i64)file_stat.st_size;
+
+    char *data;
+    {
+        std::lock_guard guard(arena_lock);
+        data = loadDestination(req, num_bytes, &result.error);
+    }
+
+    i64 offset = 0;
+    while (data != nullptr && offset < num_bytes) {
+        i64 read_size = num_bytes - offset;
+        if (read_size > max_read_bytes) {
+            read_size = max_read_bytes;
+        }
+
+        ssize_t num_read = pread(fd, data + offset, (size_t)read_size,
+                                 (off_t)offset);
+        if (num_read < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (num_read <= 0) {
+            // The file shrank after it was sized
+            result.error = num_read == 0 ? EIO : errno;
+            break;
+        }
+
+        offset += num_read;
+    }
+
+    ::close(fd);
+#elif defined(BRT_OS_WINDOWS)
+    HANDLE file = CreateFileA(req.path, GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        DWORD err = GetLastError();
+        result.error = (err == ERROR_FILE_NOT_FOUND ||
+                        err == ERROR_PATH_NOT_FOUND) ? ENOENT : EIO;
+        return result;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        result.error = EIO;
+        CloseHandle(file);
+        return result;
+    }
+
+    i64 num_bytes = (i64)file_size.QuadPart;
+
+    char *data;
+    {
+        std::lock_guard guard(arena_lock);
+        data = loadDestination(req, num_bytes, &result.error);
+    }
+
+    i64 offset = 0;
+    while (data != nullptr && offset < num_bytes) {
+        i64 read_size = num_bytes - offset;
+        if (read_size > max_read_bytes) {
+            read_size = max_read_bytes;
+        }
+
+        DWORD num_read;
+        if (!ReadFile(file, data + offset, (DWORD)read_size, &num_read,
+                      nullptr) || num_read == 0) {
+            result.error = EIO;
+            break;
+        }
+
+        offset += num_read;
+    }
+
+    CloseHandle(file);
+#else
+    i64 num_bytes = 0;
+    char *data = nullptr;
+    (void)arena_lock;
+    result.error = ENOSYS;
+#endif
+
+    if (result.error == 0) {
+        result.data = data;
+        result.numBytes = num_bytes;
+    }
+
+    return result;
+}
+
+class ThreadPoolLoader : public AsyncFileLoader::Impl {
+public:
+    ThreadPoolLoader(i32 num_threads)
+        : lock_(),
+          work_cv_(),
+          done_cv_(),
+          pending_(),
+          ready_(),
+          num_outstanding_(0),
+          stop_(false),
+          threads_(new std::thread[num_threads]),
+          num_threads_(num_threads),
+          arena_lock_()
+    {
+        for (i32 i = 0; i < num_threads_; i++) {
+            threads_[i] = std::thread([this]() { workerLoop(); });
+        }
+    }
+
+    ~ThreadPoolLoader() override
+    {
+        {
+            std::lock_guard guard(lock_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+
+        for (i32 i = 0; i < num_threads_; i++) {
+            threads_[i].join();
+        }
+
+        delete[] threads_;
+    }
+
+    void submit(const FileLoadRequest &req) override
+    {
+        {
+            std::lock_guard guard(lock_);
+            pending_.push(req);
+            num_outstanding_++;
+        }
+        work_cv_.notify_one();
+    }
+
+    i64 reap(Span<FileLoadCompletion> out, i64 min_completions) override
+    {
+        std::unique_lock guard(lock_);
+
+        i64 target = std::min(min_completions, num_outstanding_);
+        done_cv_.wait(guard, [&]() { return ready_.size() >= target; });
+
+        i64 num_out = std::min(ready_.size(), out.size());
+        for (i64 i = 0; i < num_out; i++) {
+            out[i] = ready_.pop();
+        }
+        num_outstanding_ -= num_out;
+
+        return num_out;
+    }
+
+    i64 numOutstanding() const override
+    {
+        std::lock_guard guard(lock_);
+        return num_outstanding_;
+    }
+
+    FileLoadBackend backend() const override
+    {
+        return FileLoadBackend::ThreadPool;
+    }
+
+private:
+    void workerLoop()
+    {
+        std::unique_lock guard(lock_);
+        while (true) {
+            work_cv_.wait(guard, [&]() {
+                return stop_ || pending_.size() > 0;
+            });
+
+            if (pending_.size() == 0) {
+                return;
+            }
+
+            FileLoadRequest req = pending_.pop();
+
+            guard.unlock();
+            FileLoadCompletion result = loadBlocking(req, arena_lock_);
+            guard.lock();
+
+            ready_.push(result);
+            done_cv_.notify_one();
+        }
+    }
+
+    mutable std::mutex lock_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    Queue<FileLoadRequest> pending_;
+    Queue<FileLoadCompletion> ready_;
+    i64 num_outstanding_;
+    bool stop_;
+    std::thread *threads_;
+    i32 num_threads_;
+    std::mutex arena_lock_;
+};
+
+#if defined(BRT_OS_LINUX)
+
+// io_uring driven directly through its syscalls and shared rings. Each
+// file moves through an openat, one or more reads and a close, with up to
+// queue_depth files in flight. Every request carries its slot index and
+// opcode in user_data.
+class IOUringLoader : public AsyncFileLoader::Impl {
+public:
+    static IOUringLoader * create(i32 queue_depth)
+    {
+        // Each file has at most one request in flight, so neither ring
+        // can overflow
+        u32 num_entries = u32NextPow2((u32)queue_depth);
+
+        io_uring_params params {};
+        int ring_fd = (int)syscall(__NR_io_uring_setup, num_entries,
+                                   &params);
+        if (ring_fd < 0) {
+            return nullptr;
+        }
+
+        if (!supportsOps(ring_fd)) {
+            ::close(ring_fd);
+            return nullptr;
+        }
+
+        size_t sq_ring_bytes =
+            params.sq_off.array + params.sq_entries * sizeof(u32);
+        size_t cq_ring_bytes =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_bytes = std::max(sq_ring_bytes, cq_ring_bytes);
+            cq_ring_bytes = sq_ring_bytes;
+        }
+
+        void *sq_ring = mmap(nullptr, sq_ring_bytes,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring_fd,
+                             IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) {
+            ::close(ring_fd);
+            return nullptr;
+        }
+
+        void *cq_ring = sq_ring;
+        if (!single_mmap) {
+            cq_ring = mmap(nullptr, cq_ring_bytes, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd,
+                           IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                munmap(sq_ring, sq_ring_bytes);
+                ::close(ring_fd);
+                return nullptr;
+            }
+        }
+
+        size_t sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd,
+                          IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            if (!single_mmap) {
+                munmap(cq_ring, cq_ring_bytes);
+            }
+            munmap(sq_ring, sq_ring_bytes);
+            ::close(ring_fd);
+            return nullptr;
+        }
+
+        auto *loader = new IOUringLoader();
+        loader->ring_fd_ = ring_fd;
+        loader->sq_ring_ = sq_ring;
+        loader->sq_ring_bytes_ = sq_ring_bytes;
+        loader->cq_ring_ = cq_ring;
+        loader->cq_ring_bytes_ = cq_ring_bytes;
+        loader->sqes_ = (io_uring_sqe *)sqes;
+        loader->sqes_bytes_ = sqes_bytes;
+
+        char *sq = (char *)sq_ring;
+        loader->sq_tail_ = (u32 *)(sq + params.sq_off.tail);
+        loader->sq_local_tail_ = *loader->sq_tail_;
+        loader->sq_mask_ = *(u32 *)(sq + params.sq_off.ring_mask);
+        loader->sq_array_ = (u32 *)(sq + params.sq_off.array);
+
+        char *cq = (char *)cq_ring;
+        loader->cq_head_ = (u32 *)(cq + params.cq_off.head);
+        loader->cq_tail_ = (u32 *)(cq + params.cq_off.tail);
+        loader->cq_mask_ = *(u32 *)(cq + params.cq_off.ring_mask);
+        loader->cqes_ = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+        loader->slots_ = new Slot[queue_depth];
+        for (i32 i = queue_depth - 1; i >= 0; i--) {
+            loader->free_slots_.push(i);
+        }
+
+        return loader;
+    }
+
+    ~IOUringLoader() override
+    {
+        // Completed loads may still have their CLOSE in flight; the ring
+        // must outlive them or the fds leak
+        while (num_closing_ > 0) {
+            enter(true);
+            processCompletions();
+        }
+
+        delete[] slots_;
+
+        munmap(sqes_, sqes_bytes_);
+        if (cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_bytes_);
+        }
+        munmap(sq_ring_, sq_ring_bytes_);
+        ::close(ring_fd_);
+    }
+
+    void submit(const FileLoadRequest &req) override
+    {
+        pending_.push(req);
+        num_outstanding_++;
+    }
+
+    i64 reap(Span<FileLoadCompletion> out, i64 min_completions) override
+    {
+        i64 target = std::min(min_completions, num_outstanding_);
+
+        while (true) {
+            startPending();
+
+            bool wait = ready_.size() < target;
+            if (num_unsubmitted_ > 0 || wait) {
+                enter(wait);
+            }
+
+            processCompletions();
+
+            if (ready_.size() >= target) {
+                break;
+            }
+        }
+
+        // Completions processed last may have queued READs or CLOSEs.
+        // Submit them now: once nothing is outstanding, reap() may never
+        // be called again.
+        if (num_unsubmitted_ > 0) {
+            enter(false);
+        }
+
+        i64 num_out = std::min(ready_.size(), out.size());
+        for (i64 i = 0; i < num_out; i++) {
+            out[i] = ready_.pop();
+        }
+        num_outstanding_ -= num_out;
+
+        return num_out;
+    }
+
+    i64 numOutstanding() const override
+    {
+        return num_outstanding_;
+    }
+
+    FileLoadBackend backend() const override
+    {
+        return FileLoadBackend::IOUring;
+    }
+
+private:
+    struct Slot {
+        FileLoadRequest req;
+        char *data;
+        i64 numBytes;
+        i64 bytesRead;
+        i32 fd;
+        i32 error;
+    };
+
+    IOUringLoader() = default;
+
+    static bool supportsOps(int ring_fd)
+    {
+        constexpr u32 max_ops = 256;
+        alignas(io_uring_probe) char probe_buf[
+            sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op)] {};
+        auto *probe = (io_uring_probe *)probe_buf;
+
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE,
+                    probe, max_ops) < 0) {
+            return false;
+        }
+
+        for (u32 op : { IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE }) {
+            if (op > probe->last_op ||
+                    (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    io_uring_sqe * nextSQE(i32 slot_idx, u8 opcode)
+    {
+        u32 idx = sq_local_tail_ & sq_mask_;
+
+        io_uring_sqe *sqe = &sqes_[idx];
+        *sqe = {};
+        sqe->opcode = opcode;
+        sqe->user_data = ((u64)slot_idx << 8) | opcode;
+        sq_array_[idx] = idx;
+
+        sq_local_tail_++;
+        num_unsubmitted_++;
+
+        return sqe;
+    }
+
+    void startPending()
+    {
+        while (pending_.size() > 0 && !free_slots_.isEmpty()) {
+            i32 slot_idx = free_slots_[free_slots_.size() - 1];
+            free_slots_.pop();
+
+            Slot &slot = slots_[slot_idx];
+            slot.req = pending_.pop();
+            slot.data = nullptr;
+            slot.numBytes = 0;
+            slot.bytesRead = 0;
+            slot.fd = -1;
+            slot.error = 0;
+
+            io_uring_sqe *sqe = nextSQE(slot_idx, IORING_OP_OPENAT);
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (u64)slot.req.path;
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        }
+    }
+
+    void enter(bool wait)
+    {
+        while (true) {
+            // Publish the queued SQEs to the kernel. Done on every attempt,
+            // since processCompletions() below may queue more.
+            AtomicU32Ref(*sq_tail_).store_release(sq_local_tail_);
+
+            u32 flags = wait ? IORING_ENTER_GETEVENTS : 0;
+            long num_submitted = syscall(__NR_io_uring_enter, ring_fd_,
+                                         num_unsubmitted_, wait ? 1 : 0,
+                                         flags, nullptr, 0);
+            if (num_submitted >= 0) {
+                num_unsubmitted_ -= (u32)num_submitted;
+                if (num_unsubmitted_ == 0) {
+                    return;
+                }
+
+                // The kernel stopped early, most likely to let completions
+                // be reaped
+                wait = false;
+                continue;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EBUSY) {
+                processCompletions();
+                continue;
+            }
+
+            FATAL("io_uring_enter failed: %d", errno);
+        }
+    }
+
+    void processCompletions()
+    {
+        AtomicU32Ref cq_tail(*cq_tail_);
+        u32 head = *cq_head_;
+        u32 tail = cq_tail.load_acquire();
+
+        while (head != tail) {
+            const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+            i32 slot_idx = (i32)(cqe.user_data >> 8);
+            u8 opcode = (u8)cqe.user_data;
+            i32 res = cqe.res;
+
+            head++;
+
+            handleCompletion(slot_idx, opcode, res);
+        }
+
+        AtomicU32Ref(*cq_head_).store_release(head);
+    }
+
+    void handleCompletion(i32 slot_idx, u8 opcode, i32 res)
+    {
+        Slot &slot = slots_[slot_idx];
+
+        switch (opcode) {
+            case IORING_OP_OPENAT: {
+                if (res < 0) {
+                    slot.error = -res;
+                } else {
+                    slot.fd = res;
+                }
+
+                opened(slot_idx);
+            } break;
+            case IORING_OP_READ: {
+                if (res == -EINTR || res == -EAGAIN) {
+                    queueRead(slot_idx);
+                } else if (res <= 0) {
+                    // 0 means the file shrank after it was sized
+                    slot.error = res == 0 ? EIO : -res;
+                    finish(slot_idx);
+                } else {
+                    slot.bytesRead += res;
+                    if (slot.bytesRead < slot.numBytes) {
+                        queueRead(slot_idx);
+                    } else {
+                        finish(slot_idx);
+                    }
+                }
+            } break;
+            case IORING_OP_CLOSE: {
+                slot.fd = -1;
+                num_closing_--;
+                free_slots_.push(slot_idx);
+            } break;
+            default: BRT_UNREACHABLE();
+        }
+    }
+
+    void opened(i32 slot_idx)
+    {
+        Slot &slot = slots_[slot_idx];
+        if (slot.error != 0) {
+            finish(slot_idx);
+            return;
+        }
+
+        // IORING_OP_STATX always runs on a kernel worker thread, which
+        // costs far more than an fstat on the open file
+        struct stat file_stat;
+        if (fstat(slot.fd, &file_stat) != 0) {
+            slot.error = errno;
+            finish(slot_idx);
+            return;
+        }
+
+        slot.numBytes = (i64)file_stat.st_size;
+        slot.data = loadDestination(slot.req, slot.numBytes, &slot.error);
+
+        if (slot.data == nullptr || slot.numBytes == 0) {
+            finish(slot_idx);
+        } else {
+            queueRead(slot_idx);
+        }
+    }
+
+    void queueRead(i32 slot_idx)
+    {
+        Slot &slot = slots_[slot_idx];
+
+        i64 read_size = slot.numBytes - slot.bytesRead;
+        if (read_size > max_read_bytes) {
+            read_size = max_read_bytes;
+        }
+
+        io_uring_sqe *sqe = nextSQE(slot_idx, IORING_OP_READ);
+        sqe->fd = slot.fd;
+        sqe->addr = (u64)(slot.data + slot.bytesRead);
+        sqe->len = (u32)read_size;
+        sqe->off = (u64)slot.bytesRead;
+    }
+
+    // Reports the result and closes the file, after which the slot is
+    // reused
+    void finish(i32 slot_idx)
+    {
+        Slot &slot = slots_[slot_idx];
+
+        FileLoadCompletion result {
+            .userData = slot.req.userData,
+            .data = nullptr,
+            .numBytes = 0,
+            .error = slot.error,
+        };
+
+        if (slot.error == 0) {
+            result.data = slot.data;
+            result.numBytes = slot.numBytes;
+        }
+
+        ready_.push(result);
+
+        if (slot.fd >= 0) {
+            io_uring_sqe *sqe = nextSQE(slot_idx, IORING_OP_CLOSE);
+            sqe->fd = slot.fd;
+            num_closing_++;
+        } else {
+            free_slots_.push(slot_idx);
+        }
+    }
+
+    int ring_fd_ = -1;
+    void *sq_ring_ = nullptr;
+    size_t sq_ring_bytes_ = 0;
+    void *cq_ring_ = nullptr;
+    size_t cq_ring_bytes_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_bytes_ = 0;
+
+    u32 *sq_tail_ = nullptr;
+    u32 sq_mask_ = 0;
+    u32 *sq_array_ = nullptr;
+    u32 *cq_head_ = nullptr;
+    u32 *cq_tail_ = nullptr;
+    u32 cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+    // Next SQ entry to fill; published to *sq_tail_ by enter()
+    u32 sq_local_tail_ = 0;
+    // Queued SQEs the kernel hasn't consumed yet
+    u32 num_unsubmitted_ = 0;
+    // Slots whose fd has a CLOSE queued or in flight; slot.fd stays set
+    // until it completes
+    i32 num_closing_ = 0;
+
+    Slot *slots_ = nullptr;
+    SmallVec<i32, 64> free_slots_ {};
+
+    Queue<FileLoadRequest> pending_ {};
+    Queue<FileLoadCompletion> ready_ {};
+    i64 num_outstanding_ = 0;
+};
+
+#endif
+
+}
+
+AsyncFileLoader::AsyncFileLoader(const FileLoaderConfig &cfg)
+    : impl_(nullptr)
+{
+    chk(cfg.queueDepth > 0 && cfg.numThreads > 0);
+
+#if defined(BRT_OS_LINUX)
+    if (cfg.backend != FileLoadBackend::ThreadPool) {
+        impl_ = IOUringLoader::create(cfg.queueDepth);
+    }
+#endif
+
+    if (impl_ == nullptr) {
+        if (cfg.backend == FileLoadBackend::IOUring) {
+            FATAL("io_uring is not supported on this system");
+        }
+
+        impl_ = new ThreadPoolLoader(cfg.numThreads);
+    }
+}
+
+AsyncFileLoader::~AsyncFileLoader()
+{
+    FileLoadCompletion discard[64];
+    while (impl_->numOutstanding() > 0) {
+        impl_->reap(discard, 64);
+    }
+
+    delete impl_;
+}
+
+void AsyncFileLoader::submit(const char *path, Span<char> dst,
+                             u64 user_data)
+{
+    impl_->submit(FileLoadRequest {
+        .path = path,
+        .dst = dst.data(),
+        .dstCapacity = dst.size(),
+        .arena = nullptr,
+        .alignment = 1,
+        .userData = user_data,
+    });
+}
+
+void AsyncFileLoader::submit(const char *path, StackAlloc &arena,
+                             u64 user_data, u64 alignment)
+{
+    impl_->submit(FileLoadRequest {
+        .path = path,
+        .dst = nullptr,
+        .dstCapacity = 0,
+        .arena = &arena,
+        .alignment = alignment,
+        .userData = user_data,
+    });
+}
+
+i64 AsyncFileLoader::reap(Span<FileLoadCompletion> out, i64 min_completions)
+{
+    return impl_->reap(out, min_completions);
+}
+
+i64 AsyncFileLoader::numOutstanding() const
+{
+    return impl_->numOutstanding();
+}
+
+FileLoadBackend AsyncFileLoader::backend() const
+{
+    return impl_->backend();
+}
+
+i64 loadFiles(Span<const char * const> paths, StackAlloc &arena,
+              Span<FileLoadCompletion> out, const FileLoaderConfig &cfg)
+{
+    AsyncFileLoader loader(cfg);
+
+    for (i64 i = 0; i < paths.size(); i++) {
+        loader.submit(paths[i], arena, (u64)i);
+    }
+
+    i64 num_failed = 0;
+    FileLoadCompletion completions[64];
+    while (loader.numOutstanding() > 0) {
+        i64 num_completed = loader.reap(completions, 64);
+        for (i64 i = 0; i < num_completed; i++) {
+            const FileLoadCompletion &completion = completions[i];
+            out[(i64)completion.userData] = completion;
+            num_failed += completion.error != 0;
+        }
+    }
+
+    return num_failed;
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/stack_alloc.hpp>
+
+namespace brt {
+
+struct FileLoadCompletion {
+    u64 userData;
+    // nullptr if the load failed
+    char *data;
+    i64 numBytes;
+    // 0 on success, otherwise an errno value. ENOBUFS means the file
+    // didn't fit in the caller's buffer.
+    i32 error;
+};
+
+enum class FileLoadBackend : u32 {
+    // io_uring where the kernel supports it, otherwise ThreadPool
+    Auto,
+    IOUring,
+    ThreadPool,
+};
+
+struct FileLoaderConfig {
+    // Maximum number of files in flight at once
+    i32 queueDepth = 256;
+    // Worker threads for the ThreadPool backend
+    i32 numThreads = 8;
+    FileLoadBackend backend = FileLoadBackend::Auto;
+};
+
+// Loads many whole files concurrently. On Linux, open, read and close
+// requests for up to queueDepth files are batched through one io_uring,
+// leaving an fstat as the only per file syscall, and reads of uncached
+// files overlap instead of waiting on each other. Elsewhere, or if
+// io_uring is unavailable, a pool of worker threads issues blocking
+// open / fstat / pread calls.
+//
+// With io_uring, submitted requests are queued and only handed to the
+// kernel by reap(); the ThreadPool backend starts them as soon as they're
+// submitted. Completions may be returned in any order. Paths must stay
+// valid until their load completes. A StackAlloc used as a destination
+// must not be used by anything else until all loads into it have
+// completed.
+class AsyncFileLoader {
+public:
+    AsyncFileLoader(const FileLoaderConfig &cfg = {});
+    AsyncFileLoader(const AsyncFileLoader &) = delete;
+    // Waits for outstanding loads, discarding their completions
+    ~AsyncFileLoader();
+
+    AsyncFileLoader & operator=(const AsyncFileLoader &) = delete;
+
+    // Reads the file at path into dst
+    void submit(const char *path, Span<char> dst, u64 user_data);
+    // Reads the file at path into a buffer allocated from arena
+    void submit(const char *path, StackAlloc &arena, u64 user_data,
+                u64 alignment = 64);
+
+    // Waits until min_completions loads (capped at numOutstanding()) have
+    // completed, then writes up to out.size() completions to out. Returns
+    // the number written.
+    i64 reap(Span<FileLoadCompletion> out, i64 min_completions = 1);
+
+    // Loads submitted but not yet returned by reap
+    i64 numOutstanding() const;
+    FileLoadBackend backend() const;
+
+    struct Impl;
+
+private:
+    Impl *impl_;
+};
+
+// Loads every path into memory from arena. out[i] receives the result for
+// paths[i]. Returns the number of failed loads.
+i64 loadFiles(Span<const char * const> paths, StackAlloc &arena,
+              Span<FileLoadCompletion> out,
+              const FileLoaderConfig &cfg = {});
+
+}
@@ -0,0 +1,266 @@
+#include <brt/bitset.hpp>
+#include <brt/macros.hpp>
+
+#include <bit>
+#include <new>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+#if defined(__AVX2__)
+// Per byte popcount via a nibble lookup table, summed into 64 bit lanes
+// (Mula, Kurz and Lemire, "Faster Population Counts Using AVX2
+// Instructions", 2016).
+BRT_ALWAYS_INLINE inline __m256i popcount256(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+
+    __m256i lo = _mm256_and_si256(v, low_mask);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                  _mm256_shuffle_epi8(lookup, hi));
+
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+#endif
+
+enum class BitOp {
+    And,
+    Or,
+    AndNot,
+};
+
+template <BitOp op>
+BRT_ALWAYS_INLINE inline u64 applyOp(u64 a, u64 b)
+{
+    if constexpr (op == BitOp::And) {
+        return a & b;
+    } else if constexpr (op == BitOp::Or) {
+        return a | b;
+    } else {
+        return a & ~b;
+    }
+}
+
+template <BitOp op>
+void applyOpWords(u64 *dst, const u64 *src, i64 num_words)
+{
+    i64 i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 4 <= num_words; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+
+        __m256i r;
+        if constexpr (op == BitOp::And) {
+            r = _mm256_and_si256(a, b);
+        } else if constexpr (op == BitOp::Or) {
+            r = _mm256_or_si256(a, b);
+        } else {
+            r = _mm256_andnot_si256(b, a);
+        }
+
+        _mm256_storeu_si256((__m256i *)(dst + i), r);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= num_words; i += 2) {
+        uint64x2_t a = vld1q_u64(dst + i);
+        uint64x2_t b = vld1q_u64(src + i);
+
+        uint64x2_t r;
+        if constexpr (op == BitOp::And) {
+            r = vandq_u64(a, b);
+        } else if constexpr (op == BitOp::Or) {
+            r = vorrq_u64(a, b);
+        } else {
+            r = vbicq_u64(a, b);
+        }
+
+        vst1q_u64(dst + i, r);
+    }
+#endif
+
+    for (; i < num_words; i++) {
+        dst[i] = applyOp<op>(dst[i], src[i]);
+    }
+}
+
+}
+
+i64 bitsPopcount(const u64 *words, i64 num_words)
+{
+    i64 i = 0;
+    i64 total = 0;
+
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= num_words; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(words + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(words + i + 4));
+        acc = _mm256_add_epi64(acc, popcount256(a));
+        acc = _mm256_add_epi64(acc, popcount256(b));
+    }
+
+    alignas(32) u64 lanes[4];
+    _mm256_store_si256((__m256i *)lanes, acc);
+    total = (i64)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON)
+    uint64x2_t acc = vdupq_n_u64(0);
+    for (; i + 2 <= num_words; i += 2) {
+        uint8x16_t cnt = vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(words + i)));
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(cnt)));
+    }
+
+    total = (i64)(vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1));
+#endif
+
+    for (; i < num_words; i++) {
+        total += std::popcount(words[i]);
+    }
+
+    return total;
+}
+
+i64 bitsFindNext(const u64 *words, i64 num_words, i64 start_bit)
+{
+    i64 i = start_bit >> 6;
+    if (i >= num_words) {
+        return -1;
+    }
+
+    u64 first = words[i] & (~0_u64 << (start_bit & 63));
+    if (first != 0) {
+        return i * 64 + std::countr_zero(first);
+    }
+    i += 1;
+
+    // Skip runs of empty words a vector at a time
+#if defined(__AVX2__)
+    for (; i + 4 <= num_words; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(words + i));
+        if (!_mm256_testz_si256(v, v)) {
+            break;
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= num_words; i += 2) {
+        uint64x2_t v = vld1q_u64(words + i);
+        if ((vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) != 0) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < num_words; i++) {
+        if (words[i] != 0) {
+            return i * 64 + std::countr_zero(words[i]);
+        }
+    }
+
+    return -1;
+}
+
+i64 bitsCollect(const u64 *words, i64 num_words, i64 *cursor,
+                Span<u32> out_indices)
+{
+    const i64 capacity = out_indices.size();
+    u32 *out = out_indices.data();
+    i64 num_written = 0;
+
+    i64 bit = bitsFindNext(words, num_words, *cursor);
+    if (bit == -1) {
+        *cursor = num_words * 64;
+        return 0;
+    }
+
+    i64 i = bit >> 6;
+    u64 word = words[i] & (~0_u64 << (bit & 63));
+
+    while (num_written < capacity) {
+        while (word != 0 && num_written < capacity) {
+            out[num_written++] = (u32)(i * 64 + std::countr_zero(word));
+            word &= word - 1;
+        }
+
+        if (word != 0) {
+            break;
+        }
+
+        i += 1;
+        if (i >= num_words) {
+            break;
+        }
+        word = words[i];
+    }
+
+    if (num_written > 0) {
+        *cursor = (i64)out[num_written - 1] + 1;
+    }
+
+    return num_written;
+}
+
+void bitsAnd(u64 *dst, const u64 *src, i64 num_words)
+{
+    applyOpWords<BitOp::And>(dst, src, num_words);
+}
+
+void bitsOr(u64 *dst, const u64 *src, i64 num_words)
+{
+    applyOpWords<BitOp::Or>(dst, src, num_words);
+}
+
+void bitsAndNot(u64 *dst, const u64 *src, i64 num_words)
+{
+    applyOpWords<BitOp::AndNot>(dst, src, num_words);
+}
+
+void BitSet::resize(i64 num_bits)
+{
+    i64 old_num_words = numWords();
+    i64 new_num_words = (num_bits + 63) / 64;
+
+    if (new_num_words > capacity_words_) {
+        u64 *new_words;
+        if (alloc_ != nullptr) {
+            new_words = (u64 *)alloc_->alloc(new_num_words * sizeof(u64),
+                                            BRT_CACHE_LINE);
+        } else {
+            new_words = (u64 *)operator new(new_num_words * sizeof(u64),
+                std::align_val_t(BRT_CACHE_LINE));
+        }
+
+        if (old_num_words > 0) {
+            copyN<u64>(new_words, words_, old_num_words);
+        }
+        freeWords();
+
+        words_ = new_words;
+        capacity_words_ = new_num_words;
+    }
+
+    if (new_num_words > old_num_words) {
+        zeroN<u64>(words_ + old_num_words, new_num_words - old_num_words);
+    }
+
+    // Clear bits past the new end so they don't reappear when growing
+    i64 tail_bits = num_bits & 63;
+    if (new_num_words > 0 && tail_bits != 0) {
+        words_[new_num_words - 1] &= (1_u64 << tail_bits) - 1;
+    }
+
+    num_bits_ = num_bits;
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/stack_alloc.hpp>
+
+namespace brt {
+
+// Word level kernels shared by FixedBitSet and BitSet. Bits past the end
+// of a set are kept clear, so whole words can be counted and scanned.
+i64 bitsPopcount(const u64 *words, i64 num_words);
+// Index of the first set bit at or after start_bit, or -1
+i64 bitsFindNext(const u64 *words, i64 num_words, i64 start_bit);
+// Writes up to out_indices.size() set bit indices at or after *cursor and
+// moves *cursor past the last index written. Returns the number written.
+i64 bitsCollect(const u64 *words, i64 num_words, i64 *cursor,
+                Span<u32> out_indices);
+void bitsAnd(u64 *dst, const u64 *src, i64 num_words);
+void bitsOr(u64 *dst, const u64 *src, i64 num_words);
+// dst &= ~src
+void bitsAndNot(u64 *dst, const u64 *src, i64 num_words);
+
+// Operations common to both bitsets. Derived provides words(), numWords()
+// and size(). Bulk operations require both sets to have the same size.
+template <typename Derived>
+class BitSetOps {
+public:
+    inline bool test(i64 idx) const;
+    inline void set(i64 idx);
+    inline void clear(i64 idx);
+    inline void assign(i64 idx, bool v);
+
+    inline void setAll();
+    inline void clearAll();
+
+    inline i64 count() const;
+    inline bool any() const;
+
+    inline i64 findFirst() const;
+    // First set bit after idx, or -1
+    inline i64 findNext(i64 idx) const;
+
+    // Batched iteration over set bits:
+    //   i64 cursor = 0;
+    //   while (i64 n = set.collect(&cursor, batch)) { ... }
+    inline i64 collect(i64 *cursor, Span<u32> out_indices) const;
+
+    template <typename Fn>
+    inline void forEachSet(Fn &&fn) const;
+
+    template <typename O>
+    inline Derived & operator&=(const BitSetOps<O> &o);
+    template <typename O>
+    inline Derived & operator|=(const BitSetOps<O> &o);
+    template <typename O>
+    inline Derived & andNot(const BitSetOps<O> &o);
+
+private:
+    inline Derived & self();
+    inline const Derived & self() const;
+
+    template <typename O>
+    friend class BitSetOps;
+};
+
+template <i64 N>
+class FixedBitSet : public BitSetOps<FixedBitSet<N>> {
+public:
+    static constexpr i64 numBits = N;
+    static constexpr i64 wordCount = (N + 63) / 64;
+
+    inline u64 * words() { return words_; }
+    inline const u64 * words() const { return words_; }
+    static constexpr i64 numWords() { return wordCount; }
+    static constexpr i64 size() { return N; }
+
+private:
+    static_assert(N > 0);
+
+    u64 words_[wordCount] = {};
+};
+
+// Dynamically sized bitset. Storage comes from the global allocator or,
+// if constructed with one, from a StackAlloc, in which case the BitSet
+// must not outlive the StackAlloc frame it was created in.
+class BitSet : public BitSetOps<BitSet> {
+public:
+    inline BitSet();
+    inline BitSet(i64 num_bits);
+    inline BitSet(StackAlloc &alloc, i64 num_bits);
+    BitSet(const BitSet &) = delete;
+    inline BitSet(BitSet &&o);
+    inline ~BitSet();
+
+    BitSet & operator=(const BitSet &) = delete;
+    inline BitSet & operator=(BitSet &&o);
+
+    // Bits added by growing are clear
+    void resize(i64 num_bits);
+
+    inline u64 * words() { return words_; }
+    inline const u64 * words() const { return words_; }
+    inline i64 numWords() const { return (num_bits_ + 63) / 64; }
+    inline i64 size() const { return num_bits_; }
+
+private:
+    inline void freeWords();
+
+    u64 *words_;
+    i64 num_bits_;
+    i64 capacity_words_;
+    StackAlloc *alloc_;
+};
+
+}
+
+#include "bitset.inl"
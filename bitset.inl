@@ -0,0 +1,199 @@
+#include <bit>
+#include <new>
+
+namespace brt {
+
+template <typename Derived>
+Derived & BitSetOps<Derived>::self()
+{
+    return static_cast<Derived &>(*this);
+}
+
+template <typename Derived>
+const Derived & BitSetOps<Derived>::self() const
+{
+    return static_cast<const Derived &>(*this);
+}
+
+template <typename Derived>
+bool BitSetOps<Derived>::test(i64 idx) const
+{
+    return (self().words()[idx >> 6] >> (idx & 63)) & 1;
+}
+
+template <typename Derived>
+void BitSetOps<Derived>::set(i64 idx)
+{
+    self().words()[idx >> 6] |= 1_u64 << (idx & 63);
+}
+
+template <typename Derived>
+void BitSetOps<Derived>::clear(i64 idx)
+{
+    self().words()[idx >> 6] &= ~(1_u64 << (idx & 63));
+}
+
+template <typename Derived>
+void BitSetOps<Derived>::assign(i64 idx, bool v)
+{
+    u64 &word = self().words()[idx >> 6];
+    u64 bit = 1_u64 << (idx & 63);
+    word = (word & ~bit) | ((0_u64 - (u64)v) & bit);
+}
+
+template <typename Derived>
+void BitSetOps<Derived>::setAll()
+{
+    i64 num_words = self().numWords();
+    if (num_words == 0) {
+        return;
+    }
+
+    u64 *words = self().words();
+    fillN<u64>(words, ~0_u64, num_words);
+
+    i64 tail_bits = self().size() & 63;
+    if (tail_bits != 0) {
+        words[num_words - 1] = (1_u64 << tail_bits) - 1;
+    }
+}
+
+template <typename Derived>
+void BitSetOps<Derived>::clearAll()
+{
+    zeroN<u64>(self().words(), self().numWords());
+}
+
+template <typename Derived>
+i64 BitSetOps<Derived>::count() const
+{
+    return bitsPopcount(self().words(), self().numWords());
+}
+
+template <typename Derived>
+bool BitSetOps<Derived>::any() const
+{
+    return findFirst() != -1;
+}
+
+template <typename Derived>
+i64 BitSetOps<Derived>::findFirst() const
+{
+    return bitsFindNext(self().words(), self().numWords(), 0);
+}
+
+template <typename Derived>
+i64 BitSetOps<Derived>::findNext(i64 idx) const
+{
+    return bitsFindNext(self().words(), self().numWords(), idx + 1);
+}
+
+template <typename Derived>
+i64 BitSetOps<Derived>::collect(i64 *cursor, Span<u32> out_indices) const
+{
+    return bitsCollect(self().words(), self().numWords(), cursor,
+                       out_indices);
+}
+
+template <typename Derived>
+template <typename Fn>
+void BitSetOps<Derived>::forEachSet(Fn &&fn) const
+{
+    const u64 *words = self().words();
+    i64 num_words = self().numWords();
+
+    for (i64 i = 0; i < num_words; i++) {
+        u64 word = words[i];
+        while (word != 0) {
+            fn(i * 64 + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+template <typename Derived>
+template <typename O>
+Derived & BitSetOps<Derived>::operator&=(const BitSetOps<O> &o)
+{
+    bitsAnd(self().words(), o.self().words(), self().numWords());
+    return self();
+}
+
+template <typename Derived>
+template <typename O>
+Derived & BitSetOps<Derived>::operator|=(const BitSetOps<O> &o)
+{
+    bitsOr(self().words(), o.self().words(), self().numWords());
+    return self();
+}
+
+template <typename Derived>
+template <typename O>
+Derived & BitSetOps<Derived>::andNot(const BitSetOps<O> &o)
+{
+    bitsAndNot(self().words(), o.self().words(), self().numWords());
+    return self();
+}
+
+BitSet::BitSet()
+    : words_(nullptr),
+      num_bits_(0),
+      capacity_words_(0),
+      alloc_(nullptr)
+{}
+
+BitSet::BitSet(i64 num_bits)
+    : BitSet()
+{
+    resize(num_bits);
+}
+
+BitSet::BitSet(StackAlloc &alloc, i64 num_bits)
+    : words_(nullptr),
+      num_bits_(0),
+      capacity_words_(0),
+      alloc_(&alloc)
+{
+    resize(num_bits);
+}
+
+BitSet::BitSet(BitSet &&o)
+    : words_(o.words_),
+      num_bits_(o.num_bits_),
+      capacity_words_(o.capacity_words_),
+      alloc_(o.alloc_)
+{
+    o.words_ = nullptr;
+    o.num_bits_ = 0;
+    o.capacity_words_ = 0;
+}
+
+BitSet::~BitSet()
+{
+    freeWords();
+}
+
+BitSet & BitSet::operator=(BitSet &&o)
+{
+    freeWords();
+
+    words_ = o.words_;
+    num_bits_ = o.num_bits_;
+    capacity_words_ = o.capacity_words_;
+    alloc_ = o.alloc_;
+
+    o.words_ = nullptr;
+    o.num_bits_ = 0;
+    o.capacity_words_ = 0;
+
+    return *this;
+}
+
+void BitSet::freeWords()
+{
+    if (alloc_ == nullptr && words_ != nullptr) {
+        operator delete(words_, std::align_val_t(BRT_CACHE_LINE));
+    }
+}
+
+}
@@ -0,0 +1,309 @@
+#include <brt/bloom.hpp>
+#include <brt/hash.hpp>
+#include <brt/macros.hpp>
+
+#include <cstring>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+constexpr u32 header_magic = 0x4D4C4242_u32; // "BBLM"
+constexpr u32 header_version = 1;
+
+struct Header {
+    u32 magic;
+    u32 version;
+    u64 numBlocks;
+    u8 pad[BloomFilter::headerBytes - 16];
+};
+static_assert(sizeof(Header) == BloomFilter::headerBytes);
+
+// Odd multipliers spreading the low 32 bits of the hash to one 6 bit
+// index per word (Putze, Sanders and Singler, "Cache-, Hash- and
+// Space-Efficient Bloom Filters", with salts from Impala's block filter)
+alignas(32) constexpr u32 salts[8] = {
+    0x47b6137b_u32, 0x44974d91_u32, 0x8824ad5b_u32, 0xa2b7289d_u32,
+    0x705495c7_u32, 0x2df1424b_u32, 0x9efc4947_u32, 0x5c6bfb31_u32,
+};
+
+// Hashes are looked up this far ahead of use in the bulk operations
+constexpr i64 prefetch_distance = 16;
+
+BRT_ALWAYS_INLINE inline u64 * blockPtr(u64 *blocks, i64 num_blocks,
+                                        u64 hash)
+{
+    u32 idx = u32mulhi((u32)(hash >> 32), (u32)num_blocks);
+    return blocks + (i64)idx * 8;
+}
+
+BRT_ALWAYS_INLINE inline void prefetchBlock(const u64 *block)
+{
+#if defined(BRT_CXX_MSVC) && !defined(BRT_CXX_CLANG_CL)
+    _mm_prefetch((const char *)block, _MM_HINT_T0);
+#else
+    __builtin_prefetch(block);
+#endif
+}
+
+#if defined(__AVX2__)
+
+BRT_ALWAYS_INLINE inline void blockMasks(u32 hash_lo, __m256i *m0,
+                                         __m256i *m1)
+{
+    __m256i h = _mm256_set1_epi32((i32)hash_lo);
+    __m256i idx = _mm256_srli_epi32(
+        _mm256_mullo_epi32(h, _mm256_load_si256((const __m256i *)salts)),
+        26);
+
+    __m256i one = _mm256_set1_epi64x(1);
+    *m0 = _mm256_sllv_epi64(one,
+        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(idx)));
+    *m1 = _mm256_sllv_epi64(one,
+        _mm256_cvtepu32_epi64(_mm256_extracti128_si256(idx, 1)));
+}
+
+BRT_ALWAYS_INLINE inline void setBits(u64 *block, u32 hash_lo)
+{
+    __m256i m0, m1;
+    blockMasks(hash_lo, &m0, &m1);
+
+    __m256i *b = (__m256i *)block;
+    _mm256_store_si256(b, _mm256_or_si256(_mm256_load_si256(b), m0));
+    _mm256_store_si256(b + 1, _mm256_or_si256(_mm256_load_si256(b + 1), m1));
+}
+
+BRT_ALWAYS_INLINE inline bool testBits(const u64 *block, u32 hash_lo)
+{
+    __m256i m0, m1;
+    blockMasks(hash_lo, &m0, &m1);
+
+    const __m256i *b = (const __m256i *)block;
+    // testc returns 1 if every bit of the mask is set in the block
+    return _mm256_testc_si256(_mm256_load_si256(b), m0) &
+        _mm256_testc_si256(_mm256_load_si256(b + 1), m1);
+}
+
+#elif defined(__ARM_NEON)
+
+BRT_ALWAYS_INLINE inline void blockMasks(u32 hash_lo, uint64x2_t *masks)
+{
+    uint32x4_t h = vdupq_n_u32(hash_lo);
+    uint32x4_t idx_lo = vshrq_n_u32(vmulq_u32(h, vld1q_u32(salts)), 26);
+    uint32x4_t idx_hi = vshrq_n_u32(vmulq_u32(h, vld1q_u32(salts + 4)), 26);
+
+    uint64x2_t one = vdupq_n_u64(1);
+    masks[0] = vshlq_u64(one,
+        vreinterpretq_s64_u64(vmovl_u32(vget_low_u32(idx_lo))));
+    masks[1] = vshlq_u64(one,
+        vreinterpretq_s64_u64(vmovl_u32(vget_high_u32(idx_lo))));
+    masks[2] = vshlq_u64(one,
+        vreinterpretq_s64_u64(vmovl_u32(vget_low_u32(idx_hi))));
+    masks[3] = vshlq_u64(one,
+        vreinterpretq_s64_u64(vmovl_u32(vget_high_u32(idx_hi))));
+}
+
+BRT_ALWAYS_INLINE inline void setBits(u64 *block, u32 hash_lo)
+{
+    uint64x2_t masks[4];
+    blockMasks(hash_lo, masks);
+
+    for (i32 i = 0; i < 4; i++) {
+        vst1q_u64(block + 2 * i, vorrq_u64(vld1q_u64(block + 2 * i),
+                                           masks[i]));
+    }
+}
+
+BRT_ALWAYS_INLINE inline bool testBits(const u64 *block, u32 hash_lo)
+{
+    uint64x2_t masks[4];
+    blockMasks(hash_lo, masks);
+
+    // Mask bits missing from the block
+    uint64x2_t missing = vorrq_u64(
+        vorrq_u64(vbicq_u64(masks[0], vld1q_u64(block)),
+                  vbicq_u64(masks[1], vld1q_u64(block + 2))),
+        vorrq_u64(vbicq_u64(masks[2], vld1q_u64(block + 4)),
+                  vbicq_u64(masks[3], vld1q_u64(block + 6))));
+
+    return (vgetq_lane_u64(missing, 0) | vgetq_lane_u64(missing, 1)) == 0;
+}
+
+#else
+
+BRT_ALWAYS_INLINE inline void setBits(u64 *block, u32 hash_lo)
+{
+    for (i32 i = 0; i < 8; i++) {
+        block[i] |= 1_u64 << ((hash_lo * salts[i]) >> 26);
+    }
+}
+
+BRT_ALWAYS_INLINE inline bool testBits(const u64 *block, u32 hash_lo)
+{
+    u64 missing = 0;
+    for (i32 i = 0; i < 8; i++) {
+        missing |= (1_u64 << ((hash_lo * salts[i]) >> 26)) & ~block[i];
+    }
+    return missing == 0;
+}
+
+#endif
+
+}
+
+void BloomFilter::insertHash(u64 hash)
+{
+    setBits(blockPtr(blocks_, num_blocks_, hash), (u32)hash);
+}
+
+bool BloomFilter::mayContainHash(u64 hash) const
+{
+    return testBits(blockPtr(blocks_, num_blocks_, hash), (u32)hash);
+}
+
+void BloomFilter::insertBytes(const void *data, i64 num_bytes)
+{
+    insertHash(hash64(data, num_bytes));
+}
+
+bool BloomFilter::mayContainBytes(const void *data, i64 num_bytes) const
+{
+    return mayContainHash(hash64(data, num_bytes));
+}
+
+void BloomFilter::insertHashes(Span<const u64> hashes)
+{
+    const i64 num_hashes = hashes.size();
+    const i64 num_prefetch =
+        num_hashes < prefetch_distance ? num_hashes : prefetch_distance;
+
+    for (i64 i = 0; i < num_prefetch; i++) {
+        prefetchBlock(blockPtr(blocks_, num_blocks_, hashes[i]));
+    }
+
+    for (i64 i = 0; i < num_hashes; i++) {
+        if (i + prefetch_distance < num_hashes) {
+            prefetchBlock(blockPtr(blocks_, num_blocks_,
+                                   hashes[i + prefetch_distance]));
+        }
+
+        setBits(blockPtr(blocks_, num_blocks_, hashes[i]), (u32)hashes[i]);
+    }
+}
+
+i64 BloomFilter::mayContainHashes(Span<const u64> hashes,
+                                  Span<u8> out_results) const
+{
+    const i64 num_hashes = hashes.size();
+    const i64 num_prefetch =
+        num_hashes < prefetch_distance ? num_hashes : prefetch_distance;
+
+    for (i64 i = 0; i < num_prefetch; i++) {
+        prefetchBlock(blockPtr(blocks_, num_blocks_, hashes[i]));
+    }
+
+    i64 num_hits = 0;
+    for (i64 i = 0; i < num_hashes; i++) {
+        if (i + prefetch_distance < num_hashes) {
+            prefetchBlock(blockPtr(blocks_, num_blocks_,
+                                   hashes[i + prefetch_distance]));
+        }
+
+        bool hit = testBits(blockPtr(blocks_, num_blocks_, hashes[i]),
+                            (u32)hashes[i]);
+        out_results[i] = (u8)hit;
+        num_hits += hit;
+    }
+
+    return num_hits;
+}
+
+void BloomFilter::insertKeys(Span<const u32> keys)
+{
+    constexpr i64 batch_size = 256;
+    u64 hashes[batch_size];
+
+    for (i64 offset = 0; offset < keys.size(); offset += batch_size) {
+        i64 num_keys = keys.size() - offset;
+        num_keys = num_keys < batch_size ? num_keys : batch_size;
+
+        for (i64 i = 0; i < num_keys; i++) {
+            hashes[i] = keyHash(keys[offset + i]);
+        }
+
+        insertHashes(Span<const u64>(hashes, num_keys));
+    }
+}
+
+i64 BloomFilter::mayContainKeys(Span<const u32> keys,
+                                Span<u8> out_results) const
+{
+    constexpr i64 batch_size = 256;
+    u64 hashes[batch_size];
+
+    i64 num_hits = 0;
+    for (i64 offset = 0; offset < keys.size(); offset += batch_size) {
+        i64 num_keys = keys.size() - offset;
+        num_keys = num_keys < batch_size ? num_keys : batch_size;
+
+        for (i64 i = 0; i < num_keys; i++) {
+            hashes[i] = keyHash(keys[offset + i]);
+        }
+
+        num_hits += mayContainHashes(Span<const u64>(hashes, num_keys),
+            Span<u8>(out_results.data() + offset, num_keys));
+    }
+
+    return num_hits;
+}
+
+void BloomFilter::clear()
+{
+    zeroN<u64>(blocks_, num_blocks_ * 8);
+}
+
+void BloomFilter::serialize(void *out) const
+{
+    Header header {};
+    header.magic = header_magic;
+    header.version = header_version;
+    header.numBlocks = (u64)num_blocks_;
+
+    memcpy(out, &header, sizeof(Header));
+    memcpy((char *)out + headerBytes, blocks_, numBytes());
+}
+
+bool BloomFilter::fromBuffer(void *data, i64 num_bytes, BloomFilter *out)
+{
+    if (num_bytes < headerBytes ||
+            ((uintptr_t)data & (uintptr_t)(blockBytes - 1)) != 0) {
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+
+    if (header.magic != header_magic || header.version != header_version ||
+            header.numBlocks == 0 || header.numBlocks > 0xFFFF'FFFF_u64 ||
+            (u64)(num_bytes - headerBytes) !=
+                header.numBlocks * (u64)blockBytes) {
+        return false;
+    }
+
+    BloomFilter filter;
+    filter.blocks_ = (u64 *)((char *)data + headerBytes);
+    filter.num_blocks_ = (i64)header.numBlocks;
+    filter.owns_blocks_ = false;
+
+    *out = std::move(filter);
+    return true;
+}
+
+}
@@ -0,0 +1,105 @@
+#include <brt/err.hpp>
+#include <brt/utils.hpp>
+
+#include <new>
+
+namespace brt {
+
+BloomFilter::BloomFilter()
+    : blocks_(nullptr),
+      num_blocks_(0),
+      owns_blocks_(false)
+{}
+
+BloomFilter::BloomFilter(i64 expected_keys, f32 bits_per_key)
+    : BloomFilter()
+{
+    allocBlocks(nullptr, numBlocksFor(expected_keys, bits_per_key));
+}
+
+BloomFilter::BloomFilter(StackAlloc &alloc, i64 expected_keys,
+                         f32 bits_per_key)
+    : BloomFilter()
+{
+    allocBlocks(&alloc, numBlocksFor(expected_keys, bits_per_key));
+}
+
+BloomFilter::BloomFilter(BloomFilter &&o)
+    : blocks_(o.blocks_),
+      num_blocks_(o.num_blocks_),
+      owns_blocks_(o.owns_blocks_)
+{
+    o.blocks_ = nullptr;
+    o.num_blocks_ = 0;
+    o.owns_blocks_ = false;
+}
+
+BloomFilter::~BloomFilter()
+{
+    freeBlocks();
+}
+
+BloomFilter & BloomFilter::operator=(BloomFilter &&o)
+{
+    freeBlocks();
+
+    blocks_ = o.blocks_;
+    num_blocks_ = o.num_blocks_;
+    owns_blocks_ = o.owns_blocks_;
+
+    o.blocks_ = nullptr;
+    o.num_blocks_ = 0;
+    o.owns_blocks_ = false;
+
+    return *this;
+}
+
+i64 BloomFilter::numBlocksFor(i64 expected_keys, f32 bits_per_key)
+{
+    i64 num_bits = (i64)((double)expected_keys * (double)bits_per_key);
+    i64 num_blocks = divideRoundUp<i64>(num_bits, blockBytes * 8);
+    return num_blocks < 1 ? 1 : num_blocks;
+}
+
+void BloomFilter::insert(u32 key)
+{
+    insertHash(keyHash(key));
+}
+
+bool BloomFilter::mayContain(u32 key) const
+{
+    return mayContainHash(keyHash(key));
+}
+
+// Two independent 32 bit hashes of key, the high one picks the block
+u64 BloomFilter::keyHash(u32 key)
+{
+    return ((u64)u32Hash(key) << 32) | (u64)u32Hash(key ^ 0x9E3779B9_u32);
+}
+
+void BloomFilter::allocBlocks(StackAlloc *alloc, i64 num_blocks)
+{
+    // Block indices are computed with a 32 bit multiply high
+    chk(num_blocks <= (i64)0xFFFF'FFFF);
+
+    num_blocks_ = num_blocks;
+    if (alloc == nullptr) {
+        blocks_ = (u64 *)operator new(num_blocks * blockBytes,
+                                      std::align_val_t(blockBytes));
+        owns_blocks_ = true;
+    } else {
+        blocks_ = (u64 *)alloc->alloc(num_blocks * blockBytes, blockBytes);
+        owns_blocks_ = false;
+    }
+
+    clear();
+}
+
+void BloomFilter::freeBlocks()
+{
+    if (owns_blocks_) {
+        operator delete(blocks_, std::align_val_t(blockBytes));
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/stack_alloc.hpp>
+#include <brt/utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+namespace brt {
+
+// Packs one array per type in Ts into a single allocation, using
+// computeBufferOffsets. Each array starts at a multiple of alignment(),
+// which is at least the largest alignof(Ts). A layout built in a constexpr
+// context folds all offsets to constants:
+//
+//   constexpr BufferLayout<Vector3, Quat, u32> layout(1024, 1024, 1024);
+//   auto [positions, rotations, ids] = layout.alloc(stack_alloc);
+template <typename... Ts>
+class BufferLayout {
+    template <typename T>
+    using NumElems = i64;
+
+public:
+    static constexpr i64 numBuffers = sizeof...(Ts);
+    static constexpr i64 minAlignment = std::max({ (i64)alignof(Ts)... });
+
+    constexpr BufferLayout(NumElems<Ts>... num_elems);
+    // pow2_alignment is raised to minAlignment if smaller
+    constexpr BufferLayout(std::array<i64, numBuffers> num_elems,
+                           i64 pow2_alignment);
+
+    constexpr i64 totalBytes() const { return total_bytes_; }
+    constexpr i64 alignment() const { return alignment_; }
+    constexpr i64 offset(i64 buffer_idx) const
+    {
+        return offsets_[buffer_idx];
+    }
+
+    // base must be aligned to alignment()
+    inline std::tuple<Ts *...> pointers(void *base) const;
+
+    inline std::tuple<Ts *...> alloc(StackAlloc &alloc) const;
+
+    // The first pointer is the start of the allocation and must be passed
+    // to freeHeap.
+    inline std::tuple<Ts *...> allocHeap() const;
+    inline void freeHeap(void *base) const;
+
+private:
+    static_assert(numBuffers > 0);
+
+    std::array<i64, numBuffers> offsets_;
+    i64 total_bytes_;
+    i64 alignment_;
+};
+
+}
+
+#include "buffer_layout.inl"
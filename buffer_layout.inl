@@ -0,0 +1,62 @@
+#include <new>
+#include <utility>
+
+namespace brt {
+
+template <typename... Ts>
+constexpr BufferLayout<Ts...>::BufferLayout(NumElems<Ts>... num_elems)
+    : BufferLayout(std::array<i64, numBuffers> { num_elems... },
+                   minAlignment)
+{}
+
+template <typename... Ts>
+constexpr BufferLayout<Ts...>::BufferLayout(
+        std::array<i64, numBuffers> num_elems, i64 pow2_alignment)
+    : offsets_(),
+      total_bytes_(0),
+      alignment_(std::max(pow2_alignment, minAlignment))
+{
+    constexpr std::array<i64, numBuffers> elem_sizes { (i64)sizeof(Ts)... };
+
+    std::array<i64, numBuffers> chunk_sizes {};
+    for (i64 i = 0; i < numBuffers; i++) {
+        chunk_sizes[i] = num_elems[i] * elem_sizes[i];
+    }
+
+    // computeBufferOffsets doesn't write the first chunk's offset
+    offsets_[0] = 0;
+    total_bytes_ = computeBufferOffsets(
+        chunk_sizes, Span<i64>(offsets_.data() + 1, numBuffers - 1),
+        alignment_);
+}
+
+template <typename... Ts>
+std::tuple<Ts *...> BufferLayout<Ts...>::pointers(
+    void *base) const
+{
+    return [&]<size_t... Idxs>(std::index_sequence<Idxs...>) {
+        return std::tuple<Ts *...>(
+            (Ts *)((char *)base + offsets_[Idxs])...);
+    }(std::index_sequence_for<Ts...>());
+}
+
+template <typename... Ts>
+std::tuple<Ts *...> BufferLayout<Ts...>::alloc(StackAlloc &alloc) const
+{
+    return pointers(alloc.alloc(total_bytes_, alignment_));
+}
+
+template <typename... Ts>
+std::tuple<Ts *...> BufferLayout<Ts...>::allocHeap() const
+{
+    return pointers(operator new(total_bytes_,
+                                 std::align_val_t(alignment_)));
+}
+
+template <typename... Ts>
+void BufferLayout<Ts...>::freeHeap(void *base) const
+{
+    operator delete(base, std::align_val_t(alignment_));
+}
+
+}
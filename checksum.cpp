@@ -0,0 +1,459 @@
+#include <brt/checksum.hpp>
+#include <brt/macros.hpp>
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+// Reflected CRC-32C polynomial
+constexpr u32 crc_poly = 0x82F63B78;
+
+BRT_ALWAYS_INLINE inline u64 read64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(u64));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline u32 read32(const u8 *p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(u32));
+    return v;
+}
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+
+// Byte lengths of each of the three interleaved streams. The long streams
+// amortize the cost of combining, the short ones keep medium inputs off
+// the single stream loop.
+constexpr i64 crc_long_bytes = 8192;
+constexpr i64 crc_short_bytes = 256;
+
+using GF2Matrix = std::array<u32, 32>;
+
+constexpr u32 gf2MatrixTimes(const GF2Matrix &mat, u32 vec)
+{
+    u32 sum = 0;
+    for (i32 i = 0; vec != 0; i++, vec >>= 1) {
+        if (vec & 1) {
+            sum ^= mat[i];
+        }
+    }
+
+    return sum;
+}
+
+constexpr GF2Matrix gf2MatrixSquare(const GF2Matrix &mat)
+{
+    GF2Matrix square {};
+    for (i32 i = 0; i < 32; i++) {
+        square[i] = gf2MatrixTimes(mat, mat[i]);
+    }
+
+    return square;
+}
+
+// Tables applying the operator that appends num_bytes zero bytes to a CRC,
+// one per byte of the CRC. Shifting crc0 past the other streams' bytes
+// this way lets the three streams be combined with XORs.
+consteval std::array<std::array<u32, 256>, 4> buildShiftTables(
+    i64 num_bytes)
+{
+    // Operator for one zero bit
+    GF2Matrix op {};
+    op[0] = crc_poly;
+    for (i32 i = 1; i < 32; i++) {
+        op[i] = 1u << (i - 1);
+    }
+
+    // Square up to one zero byte, then by repeated squaring up to the
+    // highest set bit of num_bytes, multiplying in each set bit
+    op = gf2MatrixSquare(gf2MatrixSquare(gf2MatrixSquare(op)));
+
+    GF2Matrix result {};
+    bool have_result = false;
+    for (i64 n = num_bytes; n != 0; n >>= 1) {
+        if (n & 1) {
+            if (!have_result) {
+                result = op;
+                have_result = true;
+            } else {
+                GF2Matrix product {};
+                for (i32 i = 0; i < 32; i++) {
+                    product[i] = gf2MatrixTimes(op, result[i]);
+                }
+                result = product;
+            }
+        }
+
+        op = gf2MatrixSquare(op);
+    }
+
+    std::array<std::array<u32, 256>, 4> tables {};
+    for (u32 b = 0; b < 256; b++) {
+        for (i32 k = 0; k < 4; k++) {
+            tables[k][b] = gf2MatrixTimes(result, b << (8 * k));
+        }
+    }
+
+    return tables;
+}
+
+constexpr auto crc_long_shift = buildShiftTables(crc_long_bytes);
+constexpr auto crc_short_shift = buildShiftTables(crc_short_bytes);
+
+BRT_ALWAYS_INLINE inline u32 crcShift(
+    const std::array<std::array<u32, 256>, 4> &tables, u32 crc)
+{
+    return tables[0][crc & 0xFF] ^ tables[1][(crc >> 8) & 0xFF] ^
+        tables[2][(crc >> 16) & 0xFF] ^ tables[3][crc >> 24];
+}
+
+BRT_ALWAYS_INLINE inline u32 crcU8(u32 crc, u8 v)
+{
+#if defined(__SSE4_2__)
+    return _mm_crc32_u8(crc, v);
+#else
+    return __crc32cb(crc, v);
+#endif
+}
+
+BRT_ALWAYS_INLINE inline u32 crcU64(u32 crc, u64 v)
+{
+#if defined(__SSE4_2__)
+    return (u32)_mm_crc32_u64(crc, v);
+#else
+    return __crc32cd(crc, v);
+#endif
+}
+
+// The crc32 instruction has a latency of 3 cycles and a throughput of 1
+// per cycle, so three independent streams keep it busy
+template <i64 stream_bytes>
+BRT_ALWAYS_INLINE inline u32 crcInterleaved(
+    u32 crc, const u8 *&p, i64 &len,
+    const std::array<std::array<u32, 256>, 4> &shift)
+{
+    while (len >= 3 * stream_bytes) {
+        u32 crc0 = crc;
+        u32 crc1 = 0;
+        u32 crc2 = 0;
+
+        for (i64 i = 0; i < stream_bytes; i += 8) {
+            crc0 = crcU64(crc0, read64(p + i));
+            crc1 = crcU64(crc1, read64(p + stream_bytes + i));
+            crc2 = crcU64(crc2, read64(p + 2 * stream_bytes + i));
+        }
+
+        crc = crcShift(shift, crc0) ^ crc1;
+        crc = crcShift(shift, crc) ^ crc2;
+
+        p += 3 * stream_bytes;
+        len -= 3 * stream_bytes;
+    }
+
+    return crc;
+}
+
+u32 crcHardware(u32 crc, const u8 *p, i64 len)
+{
+    while (len > 0 && ((uintptr_t)p & 7) != 0) {
+        crc = crcU8(crc, *p);
+        p++;
+        len--;
+    }
+
+    crc = crcInterleaved<crc_long_bytes>(crc, p, len, crc_long_shift);
+    crc = crcInterleaved<crc_short_bytes>(crc, p, len, crc_short_shift);
+
+    while (len >= 8) {
+        crc = crcU64(crc, read64(p));
+        p += 8;
+        len -= 8;
+    }
+
+    while (len > 0) {
+        crc = crcU8(crc, *p);
+        p++;
+        len--;
+    }
+
+    return crc;
+}
+
+#else
+
+using CRCTable = std::array<std::array<u32, 256>, 8>;
+
+// Tables for slicing-by-8: table[k][b] is the CRC of byte b followed by k
+// zero bytes
+consteval CRCTable buildSliceTables()
+{
+    CRCTable table {};
+
+    for (u32 b = 0; b < 256; b++) {
+        u32 crc = b;
+        for (i32 i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? crc_poly : 0);
+        }
+        table[0][b] = crc;
+    }
+
+    for (u32 b = 0; b < 256; b++) {
+        u32 crc = table[0][b];
+        for (i32 k = 1; k < 8; k++) {
+            crc = table[0][crc & 0xFF] ^ (crc >> 8);
+            table[k][b] = crc;
+        }
+    }
+
+    return table;
+}
+
+constexpr CRCTable slice_tables = buildSliceTables();
+
+u32 crcSoftware(u32 crc, const u8 *p, i64 len)
+{
+    while (len >= 8) {
+        u64 v = read64(p) ^ crc;
+        crc = slice_tables[7][v & 0xFF] ^
+            slice_tables[6][(v >> 8) & 0xFF] ^
+            slice_tables[5][(v >> 16) & 0xFF] ^
+            slice_tables[4][(v >> 24) & 0xFF] ^
+            slice_tables[3][(v >> 32) & 0xFF] ^
+            slice_tables[2][(v >> 40) & 0xFF] ^
+            slice_tables[1][(v >> 48) & 0xFF] ^
+            slice_tables[0][v >> 56];
+
+        p += 8;
+        len -= 8;
+    }
+
+    while (len > 0) {
+        crc = slice_tables[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+        p++;
+        len--;
+    }
+
+    return crc;
+}
+
+#endif
+
+constexpr u64 xxh_prime1 = 0x9E3779B185EBCA87_u64;
+constexpr u64 xxh_prime2 = 0xC2B2AE3D27D4EB4F_u64;
+constexpr u64 xxh_prime3 = 0x165667B19E3779F9_u64;
+constexpr u64 xxh_prime4 = 0x85EBCA77C2B2AE63_u64;
+constexpr u64 xxh_prime5 = 0x27D4EB2F165667C5_u64;
+
+BRT_ALWAYS_INLINE inline u64 rotl64(u64 v, i32 r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+BRT_ALWAYS_INLINE inline u64 xxhRound(u64 acc, u64 input)
+{
+    acc += input * xxh_prime2;
+    acc = rotl64(acc, 31);
+    return acc * xxh_prime1;
+}
+
+BRT_ALWAYS_INLINE inline u64 xxhMergeRound(u64 acc, u64 v)
+{
+    acc ^= xxhRound(0, v);
+    return acc * xxh_prime1 + xxh_prime4;
+}
+
+// Consumes whole 32 byte stripes, returns the number of bytes consumed
+BRT_ALWAYS_INLINE inline i64 xxhStripes(u64 *acc, const u8 *p, i64 len)
+{
+    u64 v0 = acc[0];
+    u64 v1 = acc[1];
+    u64 v2 = acc[2];
+    u64 v3 = acc[3];
+
+    i64 offset = 0;
+    for (; offset + 32 <= len; offset += 32) {
+        v0 = xxhRound(v0, read64(p + offset));
+        v1 = xxhRound(v1, read64(p + offset + 8));
+        v2 = xxhRound(v2, read64(p + offset + 16));
+        v3 = xxhRound(v3, read64(p + offset + 24));
+    }
+
+    acc[0] = v0;
+    acc[1] = v1;
+    acc[2] = v2;
+    acc[3] = v3;
+
+    return offset;
+}
+
+u64 xxhFinalize(const u64 *acc, u64 seed, i64 total_bytes,
+                const u8 *tail, i64 tail_len)
+{
+    u64 h;
+    if (total_bytes >= 32) {
+        h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) +
+            rotl64(acc[3], 18);
+        h = xxhMergeRound(h, acc[0]);
+        h = xxhMergeRound(h, acc[1]);
+        h = xxhMergeRound(h, acc[2]);
+        h = xxhMergeRound(h, acc[3]);
+    } else {
+        h = seed + xxh_prime5;
+    }
+
+    h += (u64)total_bytes;
+
+    while (tail_len >= 8) {
+        h ^= xxhRound(0, read64(tail));
+        h = rotl64(h, 27) * xxh_prime1 + xxh_prime4;
+        tail += 8;
+        tail_len -= 8;
+    }
+
+    if (tail_len >= 4) {
+        h ^= (u64)read32(tail) * xxh_prime1;
+        h = rotl64(h, 23) * xxh_prime2 + xxh_prime3;
+        tail += 4;
+        tail_len -= 4;
+    }
+
+    while (tail_len > 0) {
+        h ^= (u64)*tail * xxh_prime5;
+        h = rotl64(h, 11) * xxh_prime1;
+        tail++;
+        tail_len--;
+    }
+
+    h ^= h >> 33;
+    h *= xxh_prime2;
+    h ^= h >> 29;
+    h *= xxh_prime3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+}
+
+u32 crc32c(const void *data, i64 num_bytes, u32 crc)
+{
+    const u8 *p = (const u8 *)data;
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+    return ~crcHardware(~crc, p, num_bytes);
+#else
+    return ~crcSoftware(~crc, p, num_bytes);
+#endif
+}
+
+u64 checksum64(const void *data, i64 num_bytes, u64 seed)
+{
+    const u8 *p = (const u8 *)data;
+
+    u64 acc[4] = {
+        seed + xxh_prime1 + xxh_prime2,
+        seed + xxh_prime2,
+        seed,
+        seed - xxh_prime1,
+    };
+
+    i64 consumed = xxhStripes(acc, p, num_bytes);
+
+    return xxhFinalize(acc, seed, num_bytes, p + consumed,
+                       num_bytes - consumed);
+}
+
+Checksum64::Checksum64(u64 seed)
+    : acc_ {
+          seed + xxh_prime1 + xxh_prime2,
+          seed + xxh_prime2,
+          seed,
+          seed - xxh_prime1,
+      },
+      buffer_(),
+      buffer_used_(0),
+      total_bytes_(0),
+      seed_(seed)
+{}
+
+void Checksum64::update(const void *data, i64 num_bytes)
+{
+    const u8 *p = (const u8 *)data;
+    total_bytes_ += num_bytes;
+
+    if (buffer_used_ > 0) {
+        i64 fill = 32 - buffer_used_;
+        if (fill > num_bytes) {
+            fill = num_bytes;
+        }
+
+        memcpy(buffer_ + buffer_used_, p, (size_t)fill);
+        buffer_used_ += fill;
+        p += fill;
+        num_bytes -= fill;
+
+        if (buffer_used_ < 32) {
+            return;
+        }
+
+        xxhStripes(acc_, buffer_, 32);
+        buffer_used_ = 0;
+    }
+
+    i64 consumed = xxhStripes(acc_, p, num_bytes);
+
+    if (consumed < num_bytes) {
+        memcpy(buffer_, p + consumed, (size_t)(num_bytes - consumed));
+        buffer_used_ = num_bytes - consumed;
+    }
+}
+
+u64 Checksum64::digest() const
+{
+    return xxhFinalize(acc_, seed_, total_bytes_, buffer_, buffer_used_);
+}
+
+Checksum::Checksum(ChecksumType type)
+    : type_(type),
+      crc_(0),
+      xxh_()
+{}
+
+void Checksum::update(const void *data, i64 num_bytes)
+{
+    switch (type_) {
+        case ChecksumType::None: {
+        } break;
+        case ChecksumType::CRC32C: {
+            crc_ = crc32c(data, num_bytes, crc_);
+        } break;
+        case ChecksumType::Checksum64: {
+            xxh_.update(data, num_bytes);
+        } break;
+    }
+}
+
+u64 Checksum::value() const
+{
+    switch (type_) {
+        case ChecksumType::None: return 0;
+        case ChecksumType::CRC32C: return crc_;
+        case ChecksumType::Checksum64: return xxh_.digest();
+    }
+
+    BRT_UNREACHABLE();
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// CRC-32C (Castagnoli) of data[0, num_bytes), continuing from crc, the
+// CRC of the preceding bytes: crc32c(b, crc32c(a)) == crc32c(a || b).
+// Uses the SSE4.2 / ARMv8 CRC32 instructions over three interleaved
+// streams where available, slicing-by-8 tables otherwise.
+u32 crc32c(const void *data, i64 num_bytes, u32 crc = 0);
+
+// XXH64 of data[0, num_bytes). Bit compatible with the reference
+// implementation, so files can be verified with external tools.
+u64 checksum64(const void *data, i64 num_bytes, u64 seed = 0);
+
+// Incremental XXH64. Feeding data in any number of pieces gives the same
+// digest as checksum64 over their concatenation.
+class Checksum64 {
+public:
+    Checksum64(u64 seed = 0);
+
+    void update(const void *data, i64 num_bytes);
+    inline void update(Span<const char> data)
+    {
+        update(data.data(), data.size());
+    }
+
+    u64 digest() const;
+
+private:
+    u64 acc_[4];
+    u8 buffer_[32];
+    i64 buffer_used_;
+    i64 total_bytes_;
+    u64 seed_;
+};
+
+enum class ChecksumType : u32 {
+    None,
+    CRC32C,
+    Checksum64,
+};
+
+// Incremental checksum of a runtime selected type, used by the read paths
+// that checksum data while it's still in cache.
+class Checksum {
+public:
+    Checksum(ChecksumType type = ChecksumType::None);
+
+    inline ChecksumType type() const { return type_; }
+
+    void update(const void *data, i64 num_bytes);
+    inline void update(Span<const char> data)
+    {
+        update(data.data(), data.size());
+    }
+
+    // CRC32C results are zero extended
+    u64 value() const;
+
+private:
+    ChecksumType type_;
+    u32 crc_;
+    Checksum64 xxh_;
+};
+
+}
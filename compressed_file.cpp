@@ -0,0 +1,364 @@
+#include <brt/compressed_file.hpp>
+#include <brt/checksum.hpp>
+#include <brt/err.hpp>
+#include <brt/lz4.hpp>
+#include <brt/sync.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+namespace brt {
+
+CompressedFileWriter::CompressedFileWriter(const char *path,
+                                           const CompressedFileConfig &cfg)
+    : writer_(path, cfg.writer),
+      block_(nullptr),
+      compressed_(nullptr),
+      block_bytes_(cfg.blockBytes),
+      block_used_(0),
+      num_bytes_(0),
+      index_()
+{
+    chk(block_bytes_ > 0 && block_bytes_ <= maxCompressedBlockBytes);
+
+    if (!writer_.isOpen()) {
+        return;
+    }
+
+    block_ = (char *)allocAligned(block_bytes_, 64);
+    compressed_ = (char *)allocAligned(lz4CompressBound(block_bytes_), 64);
+
+    // Placeholder, patched by close() once the index is written
+    CompressedFileHeader header {};
+    writer_.write(Span<const char>((const char *)&header, sizeof(header)));
+}
+
+CompressedFileWriter::~CompressedFileWriter()
+{
+    abort();
+}
+
+bool CompressedFileWriter::write(Span<const char> data)
+{
+    if (!writer_.isOpen()) {
+        return false;
+    }
+
+    const char *ptr = data.data();
+    i64 remaining = data.size();
+    num_bytes_ += remaining;
+
+    if (block_used_ > 0) {
+        i64 num_copy = std::min(remaining, block_bytes_ - block_used_);
+        memcpy(block_ + block_used_, ptr, num_copy);
+        block_used_ += num_copy;
+        ptr += num_copy;
+        remaining -= num_copy;
+
+        if (block_used_ < block_bytes_) {
+            return !writer_.failed();
+        }
+
+        block_used_ = 0;
+        if (!writeBlock({ block_, block_bytes_ })) {
+            return false;
+        }
+    }
+
+    // Whole blocks are compressed straight from data
+    while (remaining >= block_bytes_) {
+        if (!writeBlock({ ptr, block_bytes_ })) {
+            return false;
+        }
+
+        ptr += block_bytes_;
+        remaining -= block_bytes_;
+    }
+
+    if (remaining > 0) {
+        memcpy(block_, ptr, remaining);
+        block_used_ = remaining;
+    }
+
+    return !writer_.failed();
+}
+
+bool CompressedFileWriter::writeBlock(Span<const char> data)
+{
+    i64 compressed_bytes = lz4Compress(data,
+        { compressed_, lz4CompressBound(block_bytes_) });
+
+    CompressedBlockEntry entry;
+    entry.offset = (u64)writer_.size();
+
+    Span<const char> stored;
+    if (compressed_bytes < data.size()) {
+        stored = { compressed_, compressed_bytes };
+        entry.storedBytes = (u32)compressed_bytes;
+    } else {
+        stored = data;
+        entry.storedBytes = (u32)data.size() | compressedBlockRawBit;
+    }
+    entry.checksum = crc32c(stored.data(), stored.size());
+
+    index_.push(entry);
+
+    return writer_.write(stored);
+}
+
+bool CompressedFileWriter::close()
+{
+    if (!writer_.isOpen()) {
+        return false;
+    }
+
+    if (block_used_ > 0) {
+        writeBlock({ block_, block_used_ });
+        block_used_ = 0;
+    }
+
+    // Align the index so the reader can use it in place
+    i64 index_offset = writer_.size();
+    i64 pad = -index_offset & (i64)(alignof(CompressedBlockEntry) - 1);
+    if (pad > 0) {
+        char zeros[alignof(CompressedBlockEntry)] = {};
+        writer_.write(Span<const char>(zeros, pad));
+        index_offset += pad;
+    }
+
+    i64 index_bytes = index_.size() * (i64)sizeof(CompressedBlockEntry);
+    writer_.write(
+        Span<const char>((const char *)index_.data(), index_bytes));
+
+    CompressedFileHeader header {};
+    header.magic = compressedFileMagic;
+    header.version = compressedFileVersion;
+    header.blockBytes = (u32)block_bytes_;
+    header.numBytes = (u64)num_bytes_;
+    header.numBlocks = (u64)index_.size();
+    header.indexOffset = (u64)index_offset;
+    header.indexChecksum = crc32c(index_.data(), index_bytes);
+    header.headerChecksum =
+        crc32c(&header, offsetof(CompressedFileHeader, headerChecksum));
+
+    writer_.writeAt(0, { (const char *)&header, sizeof(header) });
+
+    bool success = writer_.close();
+    release();
+
+    return success;
+}
+
+void CompressedFileWriter::abort()
+{
+    if (writer_.isOpen()) {
+        writer_.abort();
+    }
+
+    release();
+}
+
+void CompressedFileWriter::release()
+{
+    if (block_ != nullptr) {
+        deallocAligned(block_);
+        deallocAligned(compressed_);
+        block_ = nullptr;
+        compressed_ = nullptr;
+    }
+
+    index_.clear();
+}
+
+CompressedFileReader::CompressedFileReader()
+    : file_(),
+      index_(nullptr),
+      index_offset_(0),
+      num_bytes_(0),
+      block_bytes_(0),
+      num_blocks_(0)
+{}
+
+CompressedFileReader::CompressedFileReader(const char *path)
+    : file_(path),
+      index_(nullptr),
+      index_offset_(0),
+      num_bytes_(0),
+      block_bytes_(0),
+      num_blocks_(0)
+{
+    if (!file_.isOpen()) {
+        return;
+    }
+
+    Span<const char> data = file_.data();
+
+    CompressedFileHeader header;
+    if (data.size() < (i64)sizeof(header)) {
+        file_.close();
+        return;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    bool valid = header.magic == compressedFileMagic &&
+        header.version == compressedFileVersion &&
+        header.headerChecksum == crc32c(
+            &header, offsetof(CompressedFileHeader, headerChecksum)) &&
+        header.blockBytes > 0 &&
+        header.blockBytes <= maxCompressedBlockBytes &&
+        header.indexOffset >= sizeof(header) &&
+        header.indexOffset % alignof(CompressedBlockEntry) == 0 &&
+        header.indexOffset <= (u64)data.size() &&
+        header.numBlocks <= ((u64)data.size() - header.indexOffset) /
+            sizeof(CompressedBlockEntry) &&
+        header.numBlocks == (header.numBytes + header.blockBytes - 1) /
+            header.blockBytes;
+
+    if (valid) {
+        valid = header.indexChecksum == crc32c(
+            data.data() + header.indexOffset,
+            (i64)(header.numBlocks * sizeof(CompressedBlockEntry)));
+    }
+
+    if (!valid) {
+        file_.close();
+        return;
+    }
+
+    index_ = (const CompressedBlockEntry *)(
+        data.data() + header.indexOffset);
+    index_offset_ = (i64)header.indexOffset;
+    num_bytes_ = (i64)header.numBytes;
+    block_bytes_ = (i64)header.blockBytes;
+    num_blocks_ = (i64)header.numBlocks;
+}
+
+i64 CompressedFileReader::blockSize(i64 block_idx) const
+{
+    return std::min(block_bytes_, num_bytes_ - block_idx * block_bytes_);
+}
+
+bool CompressedFileReader::decodeBlock(i64 block_idx, char *dst) const
+{
+    const CompressedBlockEntry &entry = index_[block_idx];
+    bool raw = (entry.storedBytes & compressedBlockRawBit) != 0;
+    i64 stored_bytes = entry.storedBytes & ~compressedBlockRawBit;
+    i64 uncompressed_bytes = blockSize(block_idx);
+
+    if (entry.offset < sizeof(CompressedFileHeader) ||
+        entry.offset > (u64)index_offset_ ||
+        stored_bytes > index_offset_ - (i64)entry.offset) {
+        return false;
+    }
+
+    const char *src = file_.data().data() + entry.offset;
+    if (crc32c(src, stored_bytes) != entry.checksum) {
+        return false;
+    }
+
+    if (raw) {
+        if (stored_bytes != uncompressed_bytes) {
+            return false;
+        }
+
+        memcpy(dst, src, stored_bytes);
+        return true;
+    }
+
+    return lz4Decompress({ src, stored_bytes },
+        { dst, uncompressed_bytes }) == uncompressed_bytes;
+}
+
+bool CompressedFileReader::readRange(i64 block_idx, i64 offset,
+                                     Span<char> dst) const
+{
+    i64 block_size = blockSize(block_idx);
+    if (offset == 0 && dst.size() == block_size) {
+        return decodeBlock(block_idx, dst.data());
+    }
+
+    char *tmp = (char *)allocAligned(block_size, 64);
+    bool success = decodeBlock(block_idx, tmp);
+    if (success) {
+        memcpy(dst.data(), tmp + offset, dst.size());
+    }
+    deallocAligned(tmp);
+
+    return success;
+}
+
+bool CompressedFileReader::read(i64 offset, Span<char> dst,
+                                const ParallelFor *parallel_for) const
+{
+    if (!isOpen() || offset < 0 || offset > num_bytes_ ||
+        dst.size() > num_bytes_ - offset) {
+        return false;
+    }
+
+    if (dst.size() == 0) {
+        return true;
+    }
+
+    i64 first_block = offset / block_bytes_;
+    i64 last_block = (offset + dst.size() - 1) / block_bytes_;
+    i64 num_read_blocks = last_block - first_block + 1;
+
+    auto readBlockRange = [&](i64 i) {
+        i64 block_idx = first_block + i;
+        i64 block_start = block_idx * block_bytes_;
+        i64 start = std::max(offset, block_start);
+        i64 end = std::min(offset + dst.size(),
+                           block_start + blockSize(block_idx));
+
+        return readRange(block_idx, start - block_start,
+                         { dst.data() + (start - offset), end - start });
+    };
+
+    if (parallel_for == nullptr || num_read_blocks == 1) {
+        for (i64 i = 0; i < num_read_blocks; i++) {
+            if (!readBlockRange(i)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    AtomicI32 failed(0);
+    runParallel(*parallel_for, num_read_blocks, [&](i64 i) {
+        if (!readBlockRange(i)) {
+            failed.store_relaxed(1);
+        }
+    });
+
+    return failed.load_relaxed() == 0;
+}
+
+Span<char> CompressedFileReader::readBlock(i64 block_idx,
+                                           StackAlloc &arena) const
+{
+    chk(block_idx >= 0 && block_idx < num_blocks_);
+
+    i64 block_size = blockSize(block_idx);
+
+    AllocFrame frame = arena.push();
+    char *data = (char *)arena.alloc((u64)block_size, 64);
+
+    if (!decodeBlock(block_idx, data)) {
+        arena.pop(frame);
+        return {};
+    }
+
+    return { data, block_size };
+}
+
+void CompressedFileReader::close()
+{
+    file_.close();
+    index_ = nullptr;
+    num_bytes_ = 0;
+    block_bytes_ = 0;
+    num_blocks_ = 0;
+}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/io.hpp>
+#include <brt/small_vec.hpp>
+#include <brt/stack_alloc.hpp>
+#include <brt/utils.hpp>
+
+namespace brt {
+
+// Block compressed container. The data is split into fixed size blocks
+// that are compressed independently with lz4Compress, so any byte range
+// can be decoded by touching only the blocks that overlap it, and blocks
+// can be decoded in parallel. Layout:
+//
+//   CompressedFileHeader
+//   block 0, ..., block numBlocks - 1
+//   CompressedBlockEntry[numBlocks], the index, at indexOffset
+//
+// Blocks that don't shrink are stored raw. Each index entry holds the
+// CRC32C of the block's stored bytes, which is checked before decoding.
+// All fields are little endian.
+
+inline constexpr u32 compressedFileMagic = 0x5a545242; // "BRTZ"
+inline constexpr u32 compressedFileVersion = 1;
+inline constexpr i64 maxCompressedBlockBytes = 1 << 30;
+
+struct CompressedFileHeader {
+    u32 magic;
+    u32 version;
+    u32 blockBytes;
+    // Reserved, 0
+    u32 flags;
+    // Uncompressed size
+    u64 numBytes;
+    u64 numBlocks;
+    u64 indexOffset;
+    // CRC32C of the index
+    u32 indexChecksum;
+    // CRC32C of the header bytes before this field
+    u32 headerChecksum;
+    u8 reserved[16];
+};
+static_assert(sizeof(CompressedFileHeader) == 64);
+
+struct CompressedBlockEntry {
+    // File offset of the stored bytes
+    u64 offset;
+    // Stored size, with compressedBlockRawBit set for raw blocks
+    u32 storedBytes;
+    // CRC32C of the stored bytes
+    u32 checksum;
+};
+static_assert(sizeof(CompressedBlockEntry) == 16);
+
+inline constexpr u32 compressedBlockRawBit = 1u << 31;
+
+struct CompressedFileConfig {
+    // Uncompressed bytes per block, at most maxCompressedBlockBytes.
+    // Smaller blocks make small random reads cheaper, larger blocks
+    // compress slightly better.
+    i64 blockBytes = 256 * 1024;
+    BinaryWriterConfig writer = {};
+};
+
+// Writes a compressed container front to back. Blocks are compressed as
+// they fill up; close() writes the last block, the index and the header.
+class CompressedFileWriter {
+public:
+    // Check isOpen() for failure
+    CompressedFileWriter(const char *path,
+                         const CompressedFileConfig &cfg = {});
+    CompressedFileWriter(const CompressedFileWriter &) = delete;
+    // Aborts if close() wasn't called
+    ~CompressedFileWriter();
+
+    CompressedFileWriter & operator=(const CompressedFileWriter &) = delete;
+
+    inline bool isOpen() const { return writer_.isOpen(); }
+    // Uncompressed bytes written so far
+    inline i64 size() const { return num_bytes_; }
+    // Compressed bytes written so far, excluding the partial block
+    inline i64 compressedSize() const { return writer_.size(); }
+
+    bool write(Span<const char> data);
+
+    // Commits the file as BinaryWriter::close does. Returns false if any
+    // write failed, in which case the destination is unchanged for
+    // atomicReplace writers.
+    bool close();
+    void abort();
+
+private:
+    bool writeBlock(Span<const char> data);
+    void release();
+
+    BinaryWriter writer_;
+    char *block_;
+    char *compressed_;
+    i64 block_bytes_;
+    i64 block_used_;
+    i64 num_bytes_;
+    SmallVec<CompressedBlockEntry, 8> index_;
+};
+
+// Random access reader over a memory mapped container. The header and
+// index are validated on open, blocks when they're decoded. All reads are
+// const and decode into caller provided memory, so one reader can be
+// shared between threads.
+class CompressedFileReader {
+public:
+    CompressedFileReader();
+    // Check isOpen() for failure, including a corrupt header or index
+    CompressedFileReader(const char *path);
+    CompressedFileReader(const CompressedFileReader &) = delete;
+    CompressedFileReader(CompressedFileReader &&o) = default;
+
+    CompressedFileReader & operator=(const CompressedFileReader &) = delete;
+    CompressedFileReader & operator=(CompressedFileReader &&o) = default;
+
+    inline bool isOpen() const { return file_.isOpen(); }
+    // Uncompressed size
+    inline i64 size() const { return num_bytes_; }
+    inline i64 blockBytes() const { return block_bytes_; }
+    inline i64 numBlocks() const { return num_blocks_; }
+
+    // Decodes the uncompressed bytes [offset, offset + dst.size()) into
+    // dst. Blocks entirely inside the range are decoded in place; only the
+    // partially covered first and last blocks go through a temporary
+    // buffer. If parallel_for isn't null each block is a separate task.
+    // Returns false if the range is out of bounds or a block is corrupt.
+    bool read(i64 offset, Span<char> dst,
+              const ParallelFor *parallel_for = nullptr) const;
+
+    // Decodes block block_idx into memory allocated from arena, which is
+    // left unchanged on failure. Returns an empty span if the block is
+    // corrupt. Decoding a file block by block inside a push / pop pair
+    // keeps memory use at one block regardless of the file size.
+    Span<char> readBlock(i64 block_idx, StackAlloc &arena) const;
+
+    void close();
+
+private:
+    i64 blockSize(i64 block_idx) const;
+    bool decodeBlock(i64 block_idx, char *dst) const;
+    bool readRange(i64 block_idx, i64 offset, Span<char> dst) const;
+
+    MappedFile file_;
+    const CompressedBlockEntry *index_;
+    i64 index_offset_;
+    i64 num_bytes_;
+    i64 block_bytes_;
+    i64 num_blocks_;
+};
+
+}
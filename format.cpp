@@ -0,0 +1,444 @@
+#include <brt/format.hpp>
+#include <brt/macros.hpp>
+#include <brt/utils.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace brt {
+
+namespace {
+
+constexpr char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes the digits of v so that the last digit is at end[-1]
+BRT_ALWAYS_INLINE inline void writeDigitsBackward(char *end, u32 v)
+{
+    while (v >= 100) {
+        u32 pair = v % 100;
+        v /= 100;
+        end -= 2;
+        memcpy(end, digit_pairs + pair * 2, 2);
+    }
+
+    if (v >= 10) {
+        memcpy(end - 2, digit_pairs + v * 2, 2);
+    } else {
+        end[-1] = char('0' + v);
+    }
+}
+
+// Writes exactly 8 digits, zero padded
+BRT_ALWAYS_INLINE inline void write8Digits(char *out, u32 v)
+{
+    u32 hi = v / 10000;
+    u32 lo = v % 10000;
+
+    memcpy(out, digit_pairs + (hi / 100) * 2, 2);
+    memcpy(out + 2, digit_pairs + (hi % 100) * 2, 2);
+    memcpy(out + 4, digit_pairs + (lo / 100) * 2, 2);
+    memcpy(out + 6, digit_pairs + (lo % 100) * 2, 2);
+}
+
+// Ryu shortest round trip conversion for f32. See Ulf Adams, "Ryu: Fast
+// Float-to-String Conversion", PLDI 2018.
+namespace ryu {
+
+constexpr i32 mantissa_bits = 23;
+constexpr i32 exponent_bias = 127;
+
+constexpr i32 pow5_inv_bitcount = 59;
+constexpr i32 pow5_bitcount = 61;
+
+// floor(2^(pow5_inv_bitcount + bit_width(5^i) - 1) / 5^i) + 1
+constexpr u64 pow5_inv_split[31] = {
+    576460752303423489_u64, 461168601842738791_u64, 368934881474191033_u64,
+    295147905179352826_u64, 472236648286964522_u64, 377789318629571618_u64,
+    302231454903657294_u64, 483570327845851670_u64, 386856262276681336_u64,
+    309485009821345069_u64, 495176015714152110_u64, 396140812571321688_u64,
+    316912650057057351_u64, 507060240091291761_u64, 405648192073033409_u64,
+    324518553658426727_u64, 519229685853482763_u64, 415383748682786211_u64,
+    332306998946228969_u64, 531691198313966350_u64, 425352958651173080_u64,
+    340282366920938464_u64, 544451787073501542_u64, 435561429658801234_u64,
+    348449143727040987_u64, 557518629963265579_u64, 446014903970612463_u64,
+    356811923176489971_u64, 570899077082383953_u64, 456719261665907162_u64,
+    365375409332725730_u64
+};
+
+// 5^i truncated to its top pow5_bitcount bits
+constexpr u64 pow5_split[47] = {
+    1152921504606846976_u64, 1441151880758558720_u64,
+    1801439850948198400_u64, 2251799813685248000_u64,
+    1407374883553280000_u64, 1759218604441600000_u64,
+    2199023255552000000_u64, 1374389534720000000_u64,
+    1717986918400000000_u64, 2147483648000000000_u64,
+    1342177280000000000_u64, 1677721600000000000_u64,
+    2097152000000000000_u64, 1310720000000000000_u64,
+    1638400000000000000_u64, 2048000000000000000_u64,
+    1280000000000000000_u64, 1600000000000000000_u64,
+    2000000000000000000_u64, 1250000000000000000_u64,
+    1562500000000000000_u64, 1953125000000000000_u64,
+    1220703125000000000_u64, 1525878906250000000_u64,
+    1907348632812500000_u64, 1192092895507812500_u64,
+    1490116119384765625_u64, 1862645149230957031_u64,
+    1164153218269348144_u64, 1455191522836685180_u64,
+    1818989403545856475_u64, 2273736754432320594_u64,
+    1421085471520200371_u64, 1776356839400250464_u64,
+    2220446049250313080_u64, 1387778780781445675_u64,
+    1734723475976807094_u64, 2168404344971008868_u64,
+    1355252715606880542_u64, 1694065894508600678_u64,
+    2117582368135750847_u64, 1323488980084844279_u64,
+    1654361225106055349_u64, 2067951531382569187_u64,
+    1292469707114105741_u64, 1615587133892632177_u64,
+    2019483917365790221_u64
+};
+
+struct Decimal {
+    u32 mantissa;
+    i32 exponent;
+};
+
+// bit_width(5^e) for e in [0, 3528]
+inline i32 pow5Bits(i32 e)
+{
+    return (i32)(((u32)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)) for e in [0, 1650]
+inline u32 log10Pow2(i32 e)
+{
+    return ((u32)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)) for e in [0, 2620]
+inline u32 log10Pow5(i32 e)
+{
+    return ((u32)e * 732923) >> 20;
+}
+
+inline u32 pow5Factor(u32 v)
+{
+    u32 count = 0;
+    while (v % 5 == 0) {
+        v /= 5;
+        count += 1;
+    }
+
+    return count;
+}
+
+inline bool multipleOfPow5(u32 v, u32 p)
+{
+    return pow5Factor(v) >= p;
+}
+
+inline bool multipleOfPow2(u32 v, u32 p)
+{
+    return (v & ((1_u32 << p) - 1)) == 0;
+}
+
+inline u32 mulShift(u32 m, u64 factor, i32 shift)
+{
+    u64 lo = (u64)m * (u32)factor;
+    u64 hi = (u64)m * (u32)(factor >> 32);
+    u64 sum = (lo >> 32) + hi;
+    return (u32)(sum >> (shift - 32));
+}
+
+Decimal toDecimal(u32 ieee_mantissa, u32 ieee_exponent)
+{
+    i32 e2;
+    u32 m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - exponent_bias - mantissa_bits - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (i32)ieee_exponent - exponent_bias - mantissa_bits - 2;
+        m2 = (1_u32 << mantissa_bits) | ieee_mantissa;
+    }
+
+    const bool accept_bounds = (m2 & 1) == 0;
+
+    // Scaled value and the halfway points to its neighbors
+    const u32 mv = 4 * m2;
+    const u32 mp = 4 * m2 + 2;
+    const u32 mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    const u32 mm = 4 * m2 - 1 - mm_shift;
+
+    u32 vr, vp, vm;
+    i32 e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+    u32 last_removed_digit = 0;
+
+    if (e2 >= 0) {
+        const u32 q = log10Pow2(e2);
+        e10 = (i32)q;
+        const i32 k = pow5_inv_bitcount + pow5Bits((i32)q) - 1;
+        const i32 i = -e2 + (i32)q + k;
+        vr = mulShift(mv, pow5_inv_split[q], i);
+        vp = mulShift(mp, pow5_inv_split[q], i);
+        vm = mulShift(mm, pow5_inv_split[q], i);
+
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            const i32 l = pow5_inv_bitcount + pow5Bits((i32)q - 1) - 1;
+            last_removed_digit =
+                mulShift(mv, pow5_inv_split[q - 1], -e2 + (i32)q - 1 + l) %
+                10;
+        }
+
+        if (q <= 9) {
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = multipleOfPow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = multipleOfPow5(mm, q);
+            } else {
+                vp -= multipleOfPow5(mp, q);
+            }
+        }
+    } else {
+        const u32 q = log10Pow5(-e2);
+        e10 = (i32)q + e2;
+        const i32 i = -e2 - (i32)q;
+        const i32 k = pow5Bits(i) - pow5_bitcount;
+        i32 j = (i32)q - k;
+        vr = mulShift(mv, pow5_split[i], j);
+        vp = mulShift(mp, pow5_split[i], j);
+        vm = mulShift(mm, pow5_split[i], j);
+
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            j = (i32)q - 1 - (pow5Bits(i + 1) - pow5_bitcount);
+            last_removed_digit = mulShift(mv, pow5_split[i + 1], j) % 10;
+        }
+
+        if (q <= 1) {
+            vr_trailing_zeros = true;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp -= 1;
+            }
+        } else if (q < 31) {
+            vr_trailing_zeros = multipleOfPow2(mv, q - 1);
+        }
+    }
+
+    // Remove digits while the interval still contains a shorter value
+    i32 removed = 0;
+    u32 output;
+    if (vm_trailing_zeros || vr_trailing_zeros) [[unlikely]] {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed += 1;
+        }
+
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed += 1;
+            }
+        }
+
+        // Round half to even when exactly halfway
+        if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+            last_removed_digit = 4;
+        }
+
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+                       last_removed_digit >= 5);
+    } else {
+        while (vp / 10 > vm / 10) {
+            last_removed_digit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed += 1;
+        }
+
+        output = vr + (vr == vm || last_removed_digit >= 5);
+    }
+
+    return Decimal {
+        .mantissa = output,
+        .exponent = e10 + removed,
+    };
+}
+
+}
+
+template <typename T, typename Fn>
+inline i64 formatBatch(char *out, Span<const T> values, char separator,
+                       Fn &&format_fn)
+{
+    char *cur = out;
+    for (T v : values) {
+        cur += format_fn(cur, v);
+        *cur++ = separator;
+    }
+
+    return cur - out;
+}
+
+}
+
+i32 formatU32(char *out, u32 v)
+{
+    i32 num_digits = u32NumDigits(v);
+    writeDigitsBackward(out + num_digits, v);
+
+    return num_digits;
+}
+
+i32 formatU64(char *out, u64 v)
+{
+    if (v <= 0xFFFF'FFFF_u64) {
+        return formatU32(out, (u32)v);
+    }
+
+    i32 num_digits = u64NumDigits(v);
+    char *end = out + num_digits;
+
+    // Peel off 8 digits at a time so the remainder fits in 32 bits
+    do {
+        u32 low = (u32)(v % 100000000);
+        v /= 100000000;
+        end -= 8;
+        write8Digits(end, low);
+    } while (v > 0xFFFF'FFFF_u64);
+
+    writeDigitsBackward(end, (u32)v);
+
+    return num_digits;
+}
+
+i32 formatI64(char *out, i64 v)
+{
+    if (v < 0) {
+        out[0] = '-';
+        return 1 + formatU64(out + 1, 0_u64 - (u64)v);
+    }
+
+    return formatU64(out, (u64)v);
+}
+
+i32 formatF32(char *out, f32 v)
+{
+    u32 bits = std::bit_cast<u32>(v);
+    bool sign = (bits >> 31) != 0;
+    u32 ieee_mantissa = bits & ((1_u32 << ryu::mantissa_bits) - 1);
+    u32 ieee_exponent = (bits >> ryu::mantissa_bits) & 0xFF;
+
+    if (ieee_exponent == 0xFF) {
+        if (ieee_mantissa != 0) {
+            memcpy(out, "nan", 3);
+            return 3;
+        }
+
+        if (sign) {
+            memcpy(out, "-inf", 4);
+            return 4;
+        }
+
+        memcpy(out, "inf", 3);
+        return 3;
+    }
+
+    char *cur = out;
+    if (sign) {
+        *cur++ = '-';
+    }
+
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        *cur++ = '0';
+        return i32(cur - out);
+    }
+
+    ryu::Decimal dec = ryu::toDecimal(ieee_mantissa, ieee_exponent);
+    i32 num_digits = u32NumDigits(dec.mantissa);
+    // Number of digits before the decimal point
+    i32 point = num_digits + dec.exponent;
+
+    if (point > 0 && point <= 9) {
+        if (num_digits <= point) {
+            writeDigitsBackward(cur + num_digits, dec.mantissa);
+            memset(cur + num_digits, '0', point - num_digits);
+            cur += point;
+        } else {
+            writeDigitsBackward(cur + num_digits + 1, dec.mantissa);
+            memmove(cur, cur + 1, point);
+            cur[point] = '.';
+            cur += num_digits + 1;
+        }
+    } else if (point <= 0 && point > -4) {
+        cur[0] = '0';
+        cur[1] = '.';
+        memset(cur + 2, '0', -point);
+        cur += 2 - point;
+
+        writeDigitsBackward(cur + num_digits, dec.mantissa);
+        cur += num_digits;
+    } else {
+        writeDigitsBackward(cur + num_digits + 1, dec.mantissa);
+        cur[0] = cur[1];
+        if (num_digits > 1) {
+            cur[1] = '.';
+            cur += num_digits + 1;
+        } else {
+            cur += 1;
+        }
+
+        i32 exp = point - 1;
+        *cur++ = 'e';
+        if (exp < 0) {
+            *cur++ = '-';
+            exp = -exp;
+        } else {
+            *cur++ = '+';
+        }
+
+        if (exp >= 10) {
+            memcpy(cur, digit_pairs + exp * 2, 2);
+            cur += 2;
+        } else {
+            *cur++ = char('0' + exp);
+        }
+    }
+
+    return i32(cur - out);
+}
+
+i64 formatU32Batch(char *out, Span<const u32> values, char separator)
+{
+    return formatBatch(out, values, separator, formatU32);
+}
+
+i64 formatU64Batch(char *out, Span<const u64> values, char separator)
+{
+    return formatBatch(out, values, separator, formatU64);
+}
+
+i64 formatI64Batch(char *out, Span<const i64> values, char separator)
+{
+    return formatBatch(out, values, separator, formatI64);
+}
+
+i64 formatF32Batch(char *out, Span<const f32> values, char separator)
+{
+    return formatBatch(out, values, separator, formatF32);
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// Upper bounds on the characters written by a single call below
+inline constexpr i64 maxFormattedU32Chars = 10;
+inline constexpr i64 maxFormattedU64Chars = 20;
+inline constexpr i64 maxFormattedI64Chars = 20;
+inline constexpr i64 maxFormattedF32Chars = 15;
+
+// Write the decimal representation of v to out and return the number of
+// characters written. out must have room for the corresponding
+// maxFormatted*Chars. No null terminator is written.
+i32 formatU32(char *out, u32 v);
+i32 formatU64(char *out, u64 v);
+i32 formatI64(char *out, i64 v);
+
+// Writes the shortest decimal string that parses back to exactly v
+// (Ryu). Values whose decimal point falls within 9 digits of the first
+// significant digit print in fixed notation ("1234.5", "0.00125", "3"),
+// others in scientific notation ("1.5e+20", "-2.5e-10"). Non finite
+// values print as "nan", "inf" and "-inf".
+i32 formatF32(char *out, f32 v);
+
+// Format every value followed by separator into out, which must have room
+// for values.size() * (maxFormatted*Chars + 1) characters. Return the
+// total number of characters written.
+i64 formatU32Batch(char *out, Span<const u32> values, char separator);
+i64 formatU64Batch(char *out, Span<const u64> values, char separator);
+i64 formatI64Batch(char *out, Span<const i64> values, char separator);
+i64 formatF32Batch(char *out, Span<const f32> values, char separator);
+
+}
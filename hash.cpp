@@ -0,0 +1,378 @@
+#include <brt/hash.hpp>
+#include <brt/macros.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(BRT_CXX_MSVC) && !defined(BRT_CXX_CLANG_CL)
+#include <intrin.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+constexpr u32 fnv_basis = 2166136261u;
+constexpr u32 fnv_prime = 16777619u;
+
+// Keys for the bulk accumulator, randomly generated.
+constexpr u64 secret[32] = {
+    0x166fa5a31a882571_u64, 0x9b58ac21470a47c1_u64, 0xdf65ed76c5a67b79_u64,
+    0x95ba4a5daa5b82c5_u64, 0x45e5286d0bcc63eb_u64, 0xebbd233a2d7c8a77_u64,
+    0xbb5dcafb9e2f19a9_u64, 0x315cbbd799d8ff09_u64, 0x5f31e96c0aa7c067_u64,
+    0xd618a7a8f55fb32d_u64, 0x94bcb8d0330fea3d_u64, 0xed608a7127569a5d_u64,
+    0xe60f27b9b1e7eda5_u64, 0x05856aeb39d0796b_u64, 0x402a4cd4d9a0ec25_u64,
+    0x5ef25b28555324a5_u64, 0x62b6a7acdff88971_u64, 0xc1fa0bb4f77bf8a7_u64,
+    0xadc9eb1e63fd7bb5_u64, 0xac99a6d701ef2b6f_u64, 0x7af121c67e8e9da7_u64,
+    0x50f9e232900472f7_u64, 0x72015aecc1bb7a61_u64, 0x73155d3da0b2debf_u64,
+    0x3b60bc1c3162df6d_u64, 0x89fb15127972460f_u64, 0x2f7d03b0ffd67ed9_u64,
+    0x0b4bb060b9c70863_u64, 0x7b34b4024a7fb461_u64, 0x1460f2c18c6cbf3b_u64,
+    0x38bbf8224dfe5701_u64, 0xd471b41696e90761_u64,
+};
+
+// wyhash constants
+constexpr u64 wyp[4] = {
+    0x2d358dccaa6c78a5_u64, 0x8bb84b93962eacc9_u64,
+    0x4b33a62ed433d4a3_u64, 0x4d5a2da51de1aa47_u64,
+};
+
+constexpr i64 stripe_bytes = 64;
+constexpr i64 stripes_per_block = 16;
+constexpr i64 block_bytes = stripe_bytes * stripes_per_block;
+constexpr i64 bulk_min_bytes = 256;
+
+constexpr u64 scramble_mul = 0x9E3779B1_u64;
+
+BRT_ALWAYS_INLINE inline u64 read64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(u64));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline u64 read32(const u8 *p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(u32));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline u64 read3(const u8 *p, i64 len)
+{
+    return ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | (u64)p[len - 1];
+}
+
+BRT_ALWAYS_INLINE inline void mul128(u64 *a, u64 *b)
+{
+#if defined(BRT_CXX_MSVC) && !defined(BRT_CXX_CLANG_CL)
+    *a = _umul128(*a, *b, b);
+#else
+    __extension__ using u128 = unsigned __int128;
+    u128 r = (u128)*a * (u128)*b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#endif
+}
+
+BRT_ALWAYS_INLINE inline u64 mix(u64 a, u64 b)
+{
+    mul128(&a, &b);
+    return a ^ b;
+}
+
+BRT_ALWAYS_INLINE inline u64 finishSmall(u64 a, u64 b, u64 seed, i64 len)
+{
+    a ^= wyp[1];
+    b ^= seed;
+    mul128(&a, &b);
+    return mix(a ^ wyp[0] ^ (u64)len, b ^ wyp[1]);
+}
+
+BRT_ALWAYS_INLINE inline u64 initSeed(u64 seed)
+{
+    return seed ^ mix(seed ^ wyp[0], wyp[1]);
+}
+
+// len <= 16, seed must already be passed through initSeed
+BRT_ALWAYS_INLINE inline u64 hashSmall(const u8 *p, i64 len, u64 seed)
+{
+    u64 a, b;
+    if (len >= 4) [[likely]] {
+        i64 mid = (len >> 3) << 2;
+        a = (read32(p) << 32) | read32(p + mid);
+        b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+    } else if (len > 0) {
+        a = read3(p, len);
+        b = 0;
+    } else {
+        a = b = 0;
+    }
+
+    return finishSmall(a, b, seed, len);
+}
+
+// 16 < len < bulk_min_bytes
+u64 hashMedium(const u8 *p, i64 len, u64 seed)
+{
+    seed = initSeed(seed);
+
+    i64 i = len;
+    if (i >= 48) {
+        u64 see1 = seed, see2 = seed;
+        do {
+            seed = mix(read64(p) ^ wyp[1], read64(p + 8) ^ seed);
+            see1 = mix(read64(p + 16) ^ wyp[2], read64(p + 24) ^ see1);
+            see2 = mix(read64(p + 32) ^ wyp[3], read64(p + 40) ^ see2);
+            p += 48;
+            i -= 48;
+        } while (i >= 48);
+
+        seed ^= see1 ^ see2;
+    }
+
+    while (i > 16) {
+        seed = mix(read64(p) ^ wyp[1], read64(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+    }
+
+    return finishSmall(read64(p + i - 16), read64(p + i - 8), seed, len);
+}
+
+// Each stripe s uses the 8 keys starting at key[s]. Every lane adds the
+// neighboring input word plus a 32x32 -> 64 product of the keyed input.
+void accumulate(u64 * __restrict acc, const u8 * __restrict p,
+                i64 num_stripes, const u64 *key)
+{
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_loadu_si256((const __m256i *)acc);
+    __m256i acc1 = _mm256_loadu_si256((const __m256i *)(acc + 4));
+
+    auto lane = [](__m256i a, const u8 *d_ptr, const u64 *k_ptr) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)d_ptr);
+        __m256i k = _mm256_loadu_si256((const __m256i *)k_ptr);
+        __m256i dk = _mm256_xor_si256(d, k);
+        __m256i prod = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+        __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+        return _mm256_add_epi64(a, _mm256_add_epi64(prod, swapped));
+    };
+
+    for (i64 s = 0; s < num_stripes; s++) {
+        const u8 *stripe = p + s * stripe_bytes;
+        acc0 = lane(acc0, stripe, key + s);
+        acc1 = lane(acc1, stripe + 32, key + s + 4);
+    }
+
+    _mm256_storeu_si256((__m256i *)acc, acc0);
+    _mm256_storeu_si256((__m256i *)(acc + 4), acc1);
+#elif defined(__ARM_NEON)
+    uint64x2_t acc_v[4];
+    for (i32 i = 0; i < 4; i++) {
+        acc_v[i] = vld1q_u64(acc + 2 * i);
+    }
+
+    for (i64 s = 0; s < num_stripes; s++) {
+        const u8 *stripe = p + s * stripe_bytes;
+        for (i32 i = 0; i < 4; i++) {
+            uint64x2_t d = vreinterpretq_u64_u8(vld1q_u8(stripe + 16 * i));
+            uint64x2_t k = vld1q_u64(key + s + 2 * i);
+            uint64x2_t dk = veorq_u64(d, k);
+            uint64x2_t prod = vmull_u32(vmovn_u64(dk), vshrn_n_u64(dk, 32));
+            uint64x2_t swapped = vextq_u64(d, d, 1);
+            acc_v[i] = vaddq_u64(acc_v[i], vaddq_u64(prod, swapped));
+        }
+    }
+
+    for (i32 i = 0; i < 4; i++) {
+        vst1q_u64(acc + 2 * i, acc_v[i]);
+    }
+#else
+    for (i64 s = 0; s < num_stripes; s++) {
+        const u8 *stripe = p + s * stripe_bytes;
+        u64 d[8];
+        memcpy(d, stripe, sizeof(d));
+
+        for (i32 i = 0; i < 8; i++) {
+            u64 dk = d[i] ^ key[s + i];
+            acc[i] += d[i ^ 1] + (u64)(u32)dk * (dk >> 32);
+        }
+    }
+#endif
+}
+
+void scramble(u64 *acc, const u64 *key)
+{
+#if defined(__AVX2__)
+    const __m256i mul = _mm256_set1_epi64x((i64)scramble_mul);
+    for (i32 i = 0; i < 8; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+        __m256i k = _mm256_loadu_si256((const __m256i *)(key + i));
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, k);
+
+        // 64 x 32 bit multiply out of two 32 x 32 -> 64 multiplies
+        __m256i lo = _mm256_mul_epu32(a, mul);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mul);
+        a = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+
+        _mm256_storeu_si256((__m256i *)(acc + i), a);
+    }
+#else
+    for (i32 i = 0; i < 8; i++) {
+        u64 a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * scramble_mul;
+    }
+#endif
+}
+
+// len >= bulk_min_bytes
+u64 hashLarge(const u8 *p, i64 len, u64 seed)
+{
+    u64 acc[8];
+    for (i32 i = 0; i < 8; i++) {
+        acc[i] = secret[16 + i] ^ seed;
+    }
+
+    i64 num_blocks = (len - 1) / block_bytes;
+    for (i64 b = 0; b < num_blocks; b++) {
+        accumulate(acc, p + b * block_bytes, stripes_per_block, secret);
+        scramble(acc, secret + 24);
+    }
+
+    i64 num_stripes =
+        ((len - 1) - num_blocks * block_bytes) / stripe_bytes;
+    accumulate(acc, p + num_blocks * block_bytes, num_stripes, secret);
+
+    // The final stripe overlaps previously consumed bytes
+    accumulate(acc, p + len - stripe_bytes, 1, secret + 17);
+
+    u64 h = (u64)len * 0x9E3779B185EBCA87_u64 ^ seed;
+    for (i32 i = 0; i < 8; i += 2) {
+        h += mix(acc[i] ^ secret[8 + i], acc[i + 1] ^ secret[9 + i]);
+    }
+
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9_u64;
+    h ^= h >> 32;
+
+    return h;
+}
+
+}
+
+u32 fnv1aHash(const char *str, i64 len)
+{
+    u32 hash = fnv_basis;
+
+    // FNV-1a is a serial dependency chain, so the win here comes from
+    // fetching 8 bytes per load rather than breaking up the chain. Bytes
+    // are converted back to char so sign extension matches compileHash.
+    i64 i = 0;
+    for (; i + 8 <= len; i += 8) {
+        u64 w = read64((const u8 *)str + i);
+
+BRT_UNROLL
+        for (i32 b = 0; b < 8; b++) {
+            hash = (hash ^ (u32)(char)(w >> (8 * b))) * fnv_prime;
+        }
+    }
+
+    for (; i < len; i++) {
+        hash = (hash ^ (u32)str[i]) * fnv_prime;
+    }
+
+    // Null terminator
+    return hash * fnv_prime;
+}
+
+u64 hash64(const void *data, i64 num_bytes, u64 seed)
+{
+    const u8 *p = (const u8 *)data;
+
+    if (num_bytes <= 16) [[likely]] {
+        return hashSmall(p, num_bytes, initSeed(seed));
+    } else if (num_bytes < bulk_min_bytes) {
+        return hashMedium(p, num_bytes, seed);
+    } else {
+        return hashLarge(p, num_bytes, seed);
+    }
+}
+
+void fnv1aHashBatch(Span<const char * const> keys,
+                    Span<const i64> lens,
+                    Span<u32> out)
+{
+    const i64 num_keys = keys.size();
+
+    // Short keys of varying length would mispredict on every loop exit, so
+    // each group of 4 runs to the longest length and lanes past their end
+    // keep their current hash. Empty keys read from a dummy byte.
+    static const char empty = '\0';
+
+    auto step = [](u32 h, const char *p, i64 last, i64 j) {
+        bool active = j <= last;
+        u32 c = (u32)p[active ? j : 0];
+        u32 next = (h ^ c) * fnv_prime;
+        return active ? next : h;
+    };
+
+    i64 i = 0;
+    for (; i + 4 <= num_keys; i += 4) {
+        i64 l0 = lens[i], l1 = lens[i + 1], l2 = lens[i + 2], l3 = lens[i + 3];
+        const char *p0 = l0 > 0 ? keys[i] : &empty;
+        const char *p1 = l1 > 0 ? keys[i + 1] : &empty;
+        const char *p2 = l2 > 0 ? keys[i + 2] : &empty;
+        const char *p3 = l3 > 0 ? keys[i + 3] : &empty;
+
+        i64 max_len = std::max(std::max(l0, l1), std::max(l2, l3));
+
+        u32 h0 = fnv_basis, h1 = fnv_basis, h2 = fnv_basis, h3 = fnv_basis;
+        for (i64 j = 0; j < max_len; j++) {
+            h0 = step(h0, p0, l0 - 1, j);
+            h1 = step(h1, p1, l1 - 1, j);
+            h2 = step(h2, p2, l2 - 1, j);
+            h3 = step(h3, p3, l3 - 1, j);
+        }
+
+        out[i] = h0 * fnv_prime;
+        out[i + 1] = h1 * fnv_prime;
+        out[i + 2] = h2 * fnv_prime;
+        out[i + 3] = h3 * fnv_prime;
+    }
+
+    for (; i < num_keys; i++) {
+        out[i] = fnv1aHash(keys[i], lens[i]);
+    }
+}
+
+void hash64Batch(Span<const char * const> keys,
+                 Span<const i64> lens,
+                 Span<u64> out,
+                 u64 seed)
+{
+    const i64 num_keys = keys.size();
+    const u64 small_seed = initSeed(seed);
+
+    // The short key path is inlined and branch light, so consecutive keys
+    // are independent and overlap in the pipeline.
+    for (i64 i = 0; i < num_keys; i++) {
+        const u8 *p = (const u8 *)keys[i];
+        i64 len = lens[i];
+
+        if (len <= 16) [[likely]] {
+            out[i] = hashSmall(p, len, small_seed);
+        } else {
+            out[i] = hash64(p, len, seed);
+        }
+    }
+}
+
+}
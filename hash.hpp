@@ -0,0 +1,30 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// Runtime equivalent of compileHash(str, len): 32-bit FNV-1a over
+// str[0, len) followed by the null terminator. str[len] is never read.
+u32 fnv1aHash(const char *str, i64 len);
+
+// Fast, non-cryptographic 64-bit hash. Short inputs use a wyhash style
+// mix, inputs of 256 bytes and larger are consumed 64 bytes at a time by
+// a SIMD accumulator. Results are identical across scalar and SIMD paths,
+// but are not compatible with any external wyhash / xxh3 implementation.
+u64 hash64(const void *data, i64 num_bytes, u64 seed = 0);
+
+// Hashes keys[i][0, lens[i]) into out[i]. Independent keys are processed
+// in lock step so the latency of each hash chain overlaps with the others,
+// which is a large win over calling the single key versions for short keys.
+void fnv1aHashBatch(Span<const char * const> keys,
+                    Span<const i64> lens,
+                    Span<u32> out);
+
+void hash64Batch(Span<const char * const> keys,
+                 Span<const i64> lens,
+                 Span<u64> out,
+                 u64 seed = 0);
+
+}
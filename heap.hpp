@@ -0,0 +1,90 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/macros.hpp>
+#include <brt/span.hpp>
+#include <brt/utils.hpp>
+
+#include <algorithm>
+#include <bit>
+
+namespace brt {
+
+// 4-ary min-heap of (key, id) pairs with ids in [0, max_ids). A position
+// index maps every id to its heap slot, which makes decreaseKey, remove
+// and contains O(log n) / O(1). Keys are compared with operator<.
+//
+// Entries are offset so the four children of a node share one 4 entry
+// group aligned to entryAlignment, so for keys up to 8 bytes a group is
+// exactly one cache line.
+//
+// Storage either comes from the global allocator or from the caller, as
+// with ArrayQueue. Caller provided entries must hold
+// numEntrySlots(max_ids) Entries aligned to entryAlignment, and positions
+// must hold max_ids u32s.
+template <typename K>
+class IndexedHeap {
+public:
+    struct Entry {
+        K key;
+        u32 id;
+    };
+
+    static constexpr u32 notInHeap = 0xFFFF'FFFF;
+
+    // A cache line, or the size of a 4 entry group rounded up to a power
+    // of two if that's larger
+    static constexpr size_t entryAlignment = std::max<size_t>(
+        BRT_CACHE_LINE, std::bit_ceil(sizeof(Entry) * 4));
+
+    inline IndexedHeap(u32 max_ids);
+    inline IndexedHeap(Entry *entries, u32 *positions, u32 max_ids);
+    IndexedHeap(const IndexedHeap &) = delete;
+    inline ~IndexedHeap();
+
+    IndexedHeap & operator=(const IndexedHeap &) = delete;
+
+    // id must not already be in the heap
+    inline void push(u32 id, K key);
+    // key must not be greater than id's current key
+    inline void decreaseKey(u32 id, K key);
+    // Inserts id, or lowers its key if key is smaller than the current
+    // one. Returns false if id was already present with a key <= key.
+    inline bool pushOrDecrease(u32 id, K key);
+    inline void remove(u32 id);
+
+    inline const Entry & top() const;
+    inline Entry pop();
+
+    inline bool contains(u32 id) const;
+    inline K key(u32 id) const;
+
+    // Replaces the contents with entries in O(n). Ids must be unique.
+    inline void heapify(Span<const Entry> entries);
+    inline void clear();
+
+    inline u32 size() const { return size_; }
+    inline bool isEmpty() const { return size_ == 0; }
+    inline u32 maxIDs() const { return max_ids_; }
+
+    static constexpr u32 numEntrySlots(u32 max_ids) { return max_ids + 3; }
+
+private:
+    static constexpr u32 arity = 4;
+
+    inline void place(u32 slot, const Entry &e);
+    inline void siftUp(u32 slot, Entry e);
+    inline void siftDown(u32 slot, Entry e);
+
+    Entry *storage_;
+    // storage_ + 3, so children of slot i start at a multiple of 4
+    Entry *entries_;
+    u32 *positions_;
+    u32 size_;
+    u32 max_ids_;
+    bool owns_storage_;
+};
+
+}
+
+#include "heap.inl"
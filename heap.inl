@@ -0,0 +1,209 @@
+#include <new>
+
+namespace brt {
+
+template <typename K>
+IndexedHeap<K>::IndexedHeap(u32 max_ids)
+    : storage_((Entry *)operator new(
+          numEntrySlots(max_ids) * sizeof(Entry),
+          std::align_val_t(entryAlignment))),
+      entries_(storage_ + 3),
+      positions_((u32 *)operator new(max_ids * sizeof(u32))),
+      size_(0),
+      max_ids_(max_ids),
+      owns_storage_(true)
+{
+    fillN<u32>(positions_, notInHeap, max_ids);
+}
+
+template <typename K>
+IndexedHeap<K>::IndexedHeap(Entry *entries, u32 *positions, u32 max_ids)
+    : storage_(entries),
+      entries_(entries + 3),
+      positions_(positions),
+      size_(0),
+      max_ids_(max_ids),
+      owns_storage_(false)
+{
+    fillN<u32>(positions_, notInHeap, max_ids);
+}
+
+template <typename K>
+IndexedHeap<K>::~IndexedHeap()
+{
+    if (owns_storage_) {
+        operator delete(storage_, std::align_val_t(entryAlignment));
+        operator delete(positions_);
+    }
+}
+
+template <typename K>
+void IndexedHeap<K>::place(u32 slot, const Entry &e)
+{
+    entries_[slot] = e;
+    positions_[e.id] = slot;
+}
+
+template <typename K>
+void IndexedHeap<K>::siftUp(u32 slot, Entry e)
+{
+    while (slot > 0) {
+        u32 parent = (slot - 1) / arity;
+        if (!(e.key < entries_[parent].key)) {
+            break;
+        }
+
+        place(slot, entries_[parent]);
+        slot = parent;
+    }
+
+    place(slot, e);
+}
+
+template <typename K>
+void IndexedHeap<K>::siftDown(u32 slot, Entry e)
+{
+    while (true) {
+        u32 first_child = slot * arity + 1;
+        if (first_child >= size_) {
+            break;
+        }
+
+        u32 min_child = first_child;
+        if (first_child + arity <= size_) {
+            // All four children present: the common case, unrolled
+            u32 a = entries_[first_child + 1].key < entries_[first_child].key ?
+                first_child + 1 : first_child;
+            u32 b = entries_[first_child + 3].key <
+                    entries_[first_child + 2].key ?
+                first_child + 3 : first_child + 2;
+            min_child = entries_[b].key < entries_[a].key ? b : a;
+        } else {
+            for (u32 c = first_child + 1; c < size_; c++) {
+                if (entries_[c].key < entries_[min_child].key) {
+                    min_child = c;
+                }
+            }
+        }
+
+        if (!(entries_[min_child].key < e.key)) {
+            break;
+        }
+
+        place(slot, entries_[min_child]);
+        slot = min_child;
+    }
+
+    place(slot, e);
+}
+
+template <typename K>
+void IndexedHeap<K>::push(u32 id, K key)
+{
+    size_ += 1;
+    siftUp(size_ - 1, Entry { key, id });
+}
+
+template <typename K>
+void IndexedHeap<K>::decreaseKey(u32 id, K key)
+{
+    siftUp(positions_[id], Entry { key, id });
+}
+
+template <typename K>
+bool IndexedHeap<K>::pushOrDecrease(u32 id, K key)
+{
+    u32 slot = positions_[id];
+    if (slot == notInHeap) {
+        push(id, key);
+        return true;
+    }
+
+    if (!(key < entries_[slot].key)) {
+        return false;
+    }
+
+    siftUp(slot, Entry { key, id });
+    return true;
+}
+
+template <typename K>
+void IndexedHeap<K>::remove(u32 id)
+{
+    u32 slot = positions_[id];
+    positions_[id] = notInHeap;
+
+    size_ -= 1;
+    if (slot == size_) {
+        return;
+    }
+
+    Entry last = entries_[size_];
+    if (slot > 0 && last.key < entries_[(slot - 1) / arity].key) {
+        siftUp(slot, last);
+    } else {
+        siftDown(slot, last);
+    }
+}
+
+template <typename K>
+const typename IndexedHeap<K>::Entry & IndexedHeap<K>::top() const
+{
+    return entries_[0];
+}
+
+template <typename K>
+typename IndexedHeap<K>::Entry IndexedHeap<K>::pop()
+{
+    Entry result = entries_[0];
+    positions_[result.id] = notInHeap;
+
+    size_ -= 1;
+    if (size_ > 0) {
+        siftDown(0, entries_[size_]);
+    }
+
+    return result;
+}
+
+template <typename K>
+bool IndexedHeap<K>::contains(u32 id) const
+{
+    return positions_[id] != notInHeap;
+}
+
+template <typename K>
+K IndexedHeap<K>::key(u32 id) const
+{
+    return entries_[positions_[id]].key;
+}
+
+template <typename K>
+void IndexedHeap<K>::heapify(Span<const Entry> entries)
+{
+    clear();
+
+    size_ = (u32)entries.size();
+    for (u32 i = 0; i < size_; i++) {
+        place(i, entries[i]);
+    }
+
+    // Floyd's bottom up construction
+    if (size_ > 1) {
+        for (u32 i = (size_ - 2) / arity + 1; i-- > 0;) {
+            siftDown(i, entries_[i]);
+        }
+    }
+}
+
+template <typename K>
+void IndexedHeap<K>::clear()
+{
+    for (u32 i = 0; i < size_; i++) {
+        positions_[entries_[i].id] = notInHeap;
+    }
+
+    size_ = 0;
+}
+
+}
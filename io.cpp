@@ -1,18 +1,40 @@
 #include <brt/io.hpp>
 
 #include <brt/err.hpp>
+#include <brt/hash.hpp>
+#include <brt/small_vec.hpp>
+#include <brt/stack_alloc.hpp>
+#include <brt/sync.hpp>
 #include <brt/utils.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <mutex>
+#include <thread>
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#elif defined(BRT_OS_WINDOWS)
+#include <windows.h>
+#endif
 
 namespace brt {
 
 char * readBinaryFile(const char *path,
                       size_t buffer_alignment,
-                      size_t *out_num_bytes)
+                      size_t *out_num_bytes,
+                      Checksum *checksum)
 {
-  (void)buffer_alignment;
-
   // FIXME: look into platform specific alternatives for better
   // errors
 
@@ -29,16 +51,2143 @@ char * readBinaryFile(const char *path,
   }
 
   size_t alloc_size = roundUpPow2(num_bytes, buffer_alignment);
+  if (alloc_size == 0) {
+    alloc_size = buffer_alignment;
+  }
+
+  char *data = (char *)allocAligned(alloc_size, buffer_alignment);
+  if (data == nullptr) {
+    return nullptr;
+  }
+
+  if (checksum == nullptr) {
+    file.read(data, num_bytes);
+  } else {
+    for (size_t offset = 0; offset < num_bytes && !file.fail();
+         offset += checksumBlockBytes) {
+      size_t block_bytes = std::min(num_bytes - offset,
+                                    (size_t)checksumBlockBytes);
+      file.read(data + offset, block_bytes);
+      checksum->update(data + offset, (i64)block_bytes);
+    }
+  }
 
-  char *data = (char *)malloc(alloc_size);
-  file.read(data, num_bytes);
   if (file.fail()) {
-    free(data);
+    deallocAligned(data);
+    return nullptr;
+  }
+
+  *out_num_bytes = num_bytes;
+  return data;
+}
+
+char * readBinaryFileDirect(const char *path,
+                            size_t buffer_alignment,
+                            size_t *out_num_bytes)
+{
+  if (buffer_alignment < directReadAlignment) {
+    buffer_alignment = directReadAlignment;
+  }
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+#if defined(BRT_OS_LINUX)
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+  if (fd == -1 && errno == EINVAL) {
+    // tmpfs and some network file systems reject O_DIRECT
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  }
+#else
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd != -1) {
+    fcntl(fd, F_NOCACHE, 1);
+  }
+#endif
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t num_bytes = (size_t)file_stat.st_size;
+
+  // Direct reads must cover whole aligned blocks, so the final read may
+  // run past the end of the file into the padding
+  size_t alloc_size = roundUpPow2(num_bytes, buffer_alignment);
+  if (alloc_size == 0) {
+    alloc_size = buffer_alignment;
+  }
+
+  char *data = (char *)allocAligned(alloc_size, buffer_alignment);
+  if (data == nullptr) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t offset = 0;
+  while (offset < num_bytes) {
+    size_t read_size = alloc_size - offset;
+    if (read_size > directReadBlockBytes) {
+      read_size = directReadBlockBytes;
+    }
+
+    ssize_t num_read = pread(fd, data + offset, read_size, (off_t)offset);
+    if (num_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (num_read <= 0) {
+      deallocAligned(data);
+      ::close(fd);
+      return nullptr;
+    }
+
+    offset += (size_t)num_read;
+  }
+
+  ::close(fd);
+
+  *out_num_bytes = num_bytes;
+  return data;
+#elif defined(BRT_OS_WINDOWS)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING,
+                            FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  size_t num_bytes = (size_t)file_size.QuadPart;
+  size_t alloc_size = roundUpPow2(num_bytes, buffer_alignment);
+  if (alloc_size == 0) {
+    alloc_size = buffer_alignment;
+  }
+
+  char *data = (char *)allocAligned(alloc_size, buffer_alignment);
+  if (data == nullptr) {
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  size_t offset = 0;
+  while (offset < num_bytes) {
+    size_t read_size = alloc_size - offset;
+    if (read_size > directReadBlockBytes) {
+      read_size = directReadBlockBytes;
+    }
+
+    DWORD num_read;
+    if (!ReadFile(file, data + offset, (DWORD)read_size, &num_read,
+                  nullptr) || num_read == 0) {
+      deallocAligned(data);
+      CloseHandle(file);
+      return nullptr;
+    }
+
+    offset += num_read;
+  }
+
+  CloseHandle(file);
+
+  *out_num_bytes = num_bytes;
+  return data;
+#else
+  return readBinaryFile(path, buffer_alignment, out_num_bytes);
+#endif
+}
+
+namespace {
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS) || \
+    defined(BRT_OS_WINDOWS)
+#define BRT_POSITIONAL_READS 1
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+using ReadHandle = int;
+#else
+using ReadHandle = HANDLE;
+#endif
+
+// Opens path for positional reads from any thread. direct bypasses the
+// page cache where the file system allows it.
+bool openReadHandle(const char *path, bool direct,
+                    ReadHandle *out_file, i64 *out_num_bytes)
+{
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  int fd = -1;
+#if defined(BRT_OS_LINUX)
+  if (direct) {
+    fd = ::open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+  }
+  if (fd == -1 && (!direct || errno == EINVAL)) {
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  }
+#else
+  fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd != -1 && direct) {
+    fcntl(fd, F_NOCACHE, 1);
+  }
+#endif
+  if (fd == -1) {
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  *out_file = fd;
+  *out_num_bytes = (i64)file_stat.st_size;
+  return true;
+#else
+  DWORD flags = direct ? FILE_FLAG_NO_BUFFERING : 0;
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, flags, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  *out_file = file;
+  *out_num_bytes = (i64)file_size.QuadPart;
+  return true;
+#endif
+}
+
+void closeReadHandle(ReadHandle file)
+{
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  ::close(file);
+#else
+  CloseHandle(file);
+#endif
+}
+
+// Reads num_bytes at offset into dst, stopping early at file_size.
+// num_bytes is a multiple of directReadAlignment so direct reads never
+// request a partial block.
+bool readFileRange(ReadHandle file, char *dst, i64 offset, i64 num_bytes,
+                   i64 file_size)
+{
+  i64 stop = file_size - offset;
+  if (stop > num_bytes) {
+    stop = num_bytes;
+  }
+
+  i64 done = 0;
+  while (done < stop) {
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    ssize_t num_read = pread(file, dst + done, (size_t)(num_bytes - done),
+                             (off_t)(offset + done));
+    if (num_read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (num_read <= 0) {
+      return false;
+    }
+#else
+    i64 pos = offset + done;
+    OVERLAPPED overlapped {};
+    overlapped.Offset = (DWORD)pos;
+    overlapped.OffsetHigh = (DWORD)(pos >> 32);
+
+    DWORD num_read;
+    if (!ReadFile(file, dst + done, (DWORD)(num_bytes - done), &num_read,
+                  &overlapped) || num_read == 0) {
+      return false;
+    }
+#endif
+
+    done += (i64)num_read;
+  }
+
+  return true;
+}
+
+// Reads the first num_bytes of the file into dst, feeding each
+// checksumBlockBytes block to checksum straight after it's read
+bool readFileChecked(ReadHandle file, char *dst, i64 num_bytes,
+                     Checksum *checksum)
+{
+  if (checksum == nullptr) {
+    return readFileRange(file, dst, 0, num_bytes, num_bytes);
+  }
+
+  for (i64 offset = 0; offset < num_bytes; offset += checksumBlockBytes) {
+    i64 block_bytes = std::min(num_bytes - offset, checksumBlockBytes);
+    if (!readFileRange(file, dst + offset, offset, block_bytes, num_bytes)) {
+      return false;
+    }
+
+    checksum->update(dst + offset, block_bytes);
+  }
+
+  return true;
+}
+
+#endif
+
+}
+
+char * readBinaryFileParallel(const char *path,
+                              size_t buffer_alignment,
+                              size_t *out_num_bytes,
+                              const ParallelReadConfig &cfg,
+                              ParallelReadStats *out_stats)
+{
+  auto start = std::chrono::steady_clock::now();
+
+#ifdef BRT_POSITIONAL_READS
+  if (buffer_alignment < directReadAlignment) {
+    buffer_alignment = directReadAlignment;
+  }
+
+  i64 chunk_bytes = (i64)roundUpPow2(
+      cfg.chunkBytes > 0 ? (u64)cfg.chunkBytes : 1, directReadAlignment);
+
+  ReadHandle file;
+  i64 num_bytes;
+  if (!openReadHandle(path, cfg.direct, &file, &num_bytes)) {
+    return nullptr;
+  }
+
+  i64 alloc_size = (i64)roundUpPow2((u64)num_bytes, buffer_alignment);
+  if (alloc_size == 0) {
+    alloc_size = (i64)buffer_alignment;
+  }
+
+  char *data = (char *)allocAligned((size_t)alloc_size, buffer_alignment);
+  if (data == nullptr) {
+    closeReadHandle(file);
+    return nullptr;
+  }
+
+  const i64 num_chunks = divideRoundUp(num_bytes, chunk_bytes);
+
+  AtomicI64 next_chunk(0);
+  AtomicI32 failed(0);
+
+  auto readChunks = [&]() {
+    while (failed.load_relaxed() == 0) {
+      i64 chunk_idx = next_chunk.fetch_add_relaxed(1);
+      if (chunk_idx >= num_chunks) {
+        break;
+      }
+
+      i64 offset = chunk_idx * chunk_bytes;
+      i64 end = offset + chunk_bytes;
+      if (end > alloc_size) {
+        end = alloc_size;
+      }
+
+      if (!readFileRange(file, data + offset, offset, end - offset,
+                         num_bytes)) {
+        failed.store_relaxed(1);
+      }
+    }
+  };
+
+  i64 num_threads = cfg.numThreads < 1 ? 1 : cfg.numThreads;
+  if (num_threads > num_chunks) {
+    num_threads = num_chunks > 0 ? num_chunks : 1;
+  }
+
+  // The calling thread reads too
+  SmallVec<std::thread, 16> threads;
+  for (i64 i = 1; i < num_threads; i++) {
+    threads.emplace(readChunks);
+  }
+
+  readChunks();
+
+  for (std::thread &t : threads) {
+    t.join();
+  }
+
+  closeReadHandle(file);
+
+  if (failed.load_relaxed() != 0) {
+    deallocAligned(data);
+    return nullptr;
+  }
+#else
+  size_t num_bytes_read;
+  char *data = readBinaryFile(path, buffer_alignment, &num_bytes_read);
+  if (data == nullptr) {
+    return nullptr;
+  }
+
+  i64 num_bytes = (i64)num_bytes_read;
+#endif
+
+  if (out_stats != nullptr) {
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    out_stats->numBytes = num_bytes;
+    out_stats->seconds = seconds;
+    out_stats->gbPerSec = seconds > 0 ? (double)num_bytes / seconds / 1e9 : 0;
+  }
+
+  *out_num_bytes = (size_t)num_bytes;
+  return data;
+}
+
+char * readBinaryFile(const char *path,
+                      StackAlloc &arena,
+                      size_t buffer_alignment,
+                      size_t *out_num_bytes,
+                      Checksum *checksum)
+{
+  if (buffer_alignment < sizeof(void *)) {
+    buffer_alignment = sizeof(void *);
+  }
+
+#ifdef BRT_POSITIONAL_READS
+  ReadHandle file;
+  i64 num_bytes;
+  if (!openReadHandle(path, false, &file, &num_bytes)) {
+    return nullptr;
+  }
+
+  AllocFrame frame = arena.push();
+  char *data = (char *)arena.alloc((u64)num_bytes, buffer_alignment);
+
+  bool success = readFileChecked(file, data, num_bytes, checksum);
+  closeReadHandle(file);
+
+  if (!success) {
+    arena.pop(frame);
+    return nullptr;
+  }
+
+  *out_num_bytes = (size_t)num_bytes;
+  return data;
+#else
+  size_t num_bytes;
+  char *tmp = readBinaryFile(path, buffer_alignment, &num_bytes, checksum);
+  if (tmp == nullptr) {
     return nullptr;
   }
 
+  char *data = (char *)arena.alloc((u64)num_bytes, buffer_alignment);
+  memcpy(data, tmp, num_bytes);
+  deallocAligned(tmp);
+
   *out_num_bytes = num_bytes;
   return data;
+#endif
+}
+
+bool readBinaryFile(const char *path,
+                    Span<char> dst,
+                    size_t *out_num_bytes,
+                    Checksum *checksum)
+{
+#ifdef BRT_POSITIONAL_READS
+  ReadHandle file;
+  i64 num_bytes;
+  if (!openReadHandle(path, false, &file, &num_bytes)) {
+    return false;
+  }
+
+  bool success = num_bytes <= dst.size() &&
+    readFileChecked(file, dst.data(), num_bytes, checksum);
+  closeReadHandle(file);
+
+  if (!success) {
+    return false;
+  }
+
+  *out_num_bytes = (size_t)num_bytes;
+  return true;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  i64 num_bytes = file.tellg();
+  if (num_bytes > dst.size()) {
+    return false;
+  }
+
+  file.seekg(std::ios::beg);
+  file.read(dst.data(), num_bytes);
+  if (!file) {
+    return false;
+  }
+
+  if (checksum != nullptr) {
+    checksum->update(dst.data(), num_bytes);
+  }
+
+  *out_num_bytes = (size_t)num_bytes;
+  return true;
+#endif
+}
+
+i64 fileSize(const char *path)
+{
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  struct stat file_stat;
+  if (stat(path, &file_stat) != 0) {
+    return -1;
+  }
+
+  return (i64)file_stat.st_size;
+#elif defined(BRT_OS_WINDOWS)
+  WIN32_FILE_ATTRIBUTE_DATA attrs;
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attrs)) {
+    return -1;
+  }
+
+  return ((i64)attrs.nFileSizeHigh << 32) | (i64)attrs.nFileSizeLow;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return -1;
+  }
+
+  return (i64)file.tellg();
+#endif
+}
+
+MappedFile::MappedFile()
+  : data_(nullptr),
+    num_bytes_(0),
+    mode_(Mode::ReadOnly),
+    open_(false)
+{}
+
+MappedFile::MappedFile(const char *path, Mode mode)
+  : MappedFile()
+{
+  mode_ = mode;
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ::close(fd);
+    return;
+  }
+
+  i64 num_bytes = (i64)file_stat.st_size;
+  if (num_bytes > 0) {
+    int prot = mode == Mode::CopyOnWrite ? (PROT_READ | PROT_WRITE) :
+        PROT_READ;
+
+    void *mapping = mmap(nullptr, (size_t)num_bytes, prot, MAP_PRIVATE,
+                         fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      return;
+    }
+
+    data_ = (char *)mapping;
+  }
+
+  // The mapping holds its own reference to the file
+  ::close(fd);
+#elif defined(BRT_OS_WINDOWS)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return;
+  }
+
+  i64 num_bytes = (i64)file_size.QuadPart;
+  if (num_bytes > 0) {
+    HANDLE mapping = CreateFileMappingA(file, nullptr,
+        mode == Mode::CopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY,
+        0, 0, nullptr);
+    if (mapping == nullptr) {
+      CloseHandle(file);
+      return;
+    }
+
+    void *view = MapViewOfFile(mapping,
+        mode == Mode::CopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+
+    // The view keeps the mapping and file alive
+    CloseHandle(mapping);
+    if (view == nullptr) {
+      CloseHandle(file);
+      return;
+    }
+
+    data_ = (char *)view;
+  }
+
+  CloseHandle(file);
+#else
+  (void)path;
+  i64 num_bytes = 0;
+  return;
+#endif
+
+  num_bytes_ = num_bytes;
+  open_ = true;
+}
+
+MappedFile::MappedFile(MappedFile &&o)
+  : data_(o.data_),
+    num_bytes_(o.num_bytes_),
+    mode_(o.mode_),
+    open_(o.open_)
+{
+  o.data_ = nullptr;
+  o.num_bytes_ = 0;
+  o.open_ = false;
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+MappedFile & MappedFile::operator=(MappedFile &&o)
+{
+  close();
+
+  data_ = o.data_;
+  num_bytes_ = o.num_bytes_;
+  mode_ = o.mode_;
+  open_ = o.open_;
+
+  o.data_ = nullptr;
+  o.num_bytes_ = 0;
+  o.open_ = false;
+
+  return *this;
+}
+
+Span<char> MappedFile::mutableData() const
+{
+  chk(mode_ == Mode::CopyOnWrite);
+  return { data_, num_bytes_ };
+}
+
+bool MappedFile::advise(Advice advice, i64 offset, i64 num_bytes) const
+{
+  if (num_bytes == -1) {
+    num_bytes = num_bytes_ - offset;
+  }
+
+  if (data_ == nullptr || num_bytes <= 0) {
+    return true;
+  }
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  int posix_advice;
+  switch (advice) {
+    case Advice::Normal: posix_advice = MADV_NORMAL; break;
+    case Advice::Sequential: posix_advice = MADV_SEQUENTIAL; break;
+    case Advice::Random: posix_advice = MADV_RANDOM; break;
+    case Advice::WillNeed: posix_advice = MADV_WILLNEED; break;
+    case Advice::HugePage: {
+#ifdef MADV_HUGEPAGE
+      posix_advice = MADV_HUGEPAGE;
+      break;
+#else
+      return false;
+#endif
+    }
+    default: BRT_UNREACHABLE();
+  }
+
+  // madvise ranges must start on a page boundary
+  uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)(data_ + offset);
+  uintptr_t page_start = start & ~(page_size - 1);
+
+  return madvise((void *)page_start,
+                 (size_t)(start - page_start + (uintptr_t)num_bytes),
+                 posix_advice) == 0;
+#elif defined(BRT_OS_WINDOWS)
+  if (advice != Advice::WillNeed) {
+    return advice == Advice::Normal;
+  }
+
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = data_ + offset;
+  range.NumberOfBytes = (SIZE_T)num_bytes;
+
+  return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+  (void)advice;
+  return false;
+#endif
+}
+
+void MappedFile::checksum(Checksum &checksum, i64 offset,
+                          i64 num_bytes) const
+{
+  if (num_bytes == -1) {
+    num_bytes = num_bytes_ - offset;
+  }
+
+  // Keep a few blocks of read ahead in flight so page faults on the
+  // checksummed block are mostly already satisfied
+  constexpr i64 readahead_blocks = 4;
+
+  i64 end = offset + num_bytes;
+  advise(Advice::WillNeed, offset,
+         std::min(num_bytes, readahead_blocks * checksumBlockBytes));
+
+  for (i64 block = offset; block < end; block += checksumBlockBytes) {
+    i64 ahead = block + readahead_blocks * checksumBlockBytes;
+    if (ahead < end) {
+      advise(Advice::WillNeed, ahead, std::min(checksumBlockBytes,
+                                               end - ahead));
+    }
+
+    checksum.update(data_ + block, std::min(checksumBlockBytes, end - block));
+  }
+}
+
+void MappedFile::close()
+{
+  if (data_ != nullptr) {
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    munmap(data_, (size_t)num_bytes_);
+#elif defined(BRT_OS_WINDOWS)
+    UnmapViewOfFile(data_);
+#endif
+  }
+
+  data_ = nullptr;
+  num_bytes_ = 0;
+  open_ = false;
+}
+
+#ifdef BRT_POSITIONAL_READS
+
+struct StreamReader::Impl {
+  ReadHandle file;
+  i64 numBytes;
+  i64 blockBytes;
+  i64 numBlocks;
+  i32 numBuffers;
+  // numBuffers blocks; block i is read into buffer i % numBuffers
+  char *buffers;
+
+  std::mutex lock;
+  std::condition_variable readCV;
+  std::condition_variable releaseCV;
+  // Blocks read by the helper thread / released back by the caller
+  i64 numRead;
+  i64 numReleased;
+  // Block held by the caller, -1 before the first call to next()
+  i64 current;
+  bool readFailed;
+  bool stop;
+
+  // Only touched by the helper thread until the last block is read
+  Checksum checksum;
+
+  std::thread thread;
+
+  void readLoop()
+  {
+    for (i64 block = 0; block < numBlocks; block++) {
+      {
+        std::unique_lock guard(lock);
+        releaseCV.wait(guard, [&]() {
+          return stop || block - numReleased < numBuffers;
+        });
+
+        if (stop) {
+          return;
+        }
+      }
+
+      char *dst = buffers + (block % numBuffers) * blockBytes;
+      bool success = readFileRange(file, dst, block * blockBytes,
+                                   blockBytes, numBytes);
+      if (success) {
+        checksum.update(dst, std::min(blockBytes,
+                                      numBytes - block * blockBytes));
+      }
+
+      {
+        std::lock_guard guard(lock);
+        if (success) {
+          numRead = block + 1;
+        } else {
+          readFailed = true;
+        }
+      }
+      readCV.notify_one();
+
+      if (!success) {
+        return;
+      }
+    }
+  }
+};
+
+#else
+
+struct StreamReader::Impl {};
+
+#endif
+
+StreamReader::StreamReader()
+  : impl_(nullptr)
+{}
+
+StreamReader::StreamReader(const char *path, const StreamReaderConfig &cfg)
+  : StreamReader()
+{
+#ifdef BRT_POSITIONAL_READS
+  ReadHandle file;
+  i64 num_bytes;
+  if (!openReadHandle(path, cfg.direct, &file, &num_bytes)) {
+    return;
+  }
+
+#if defined(BRT_OS_LINUX)
+  if (!cfg.direct) {
+    posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+#endif
+
+  i64 block_bytes = (i64)roundUpPow2(
+      cfg.blockBytes > 0 ? (u64)cfg.blockBytes : 1, directReadAlignment);
+  i32 num_buffers = cfg.numBuffers < 2 ? 2 : cfg.numBuffers;
+
+  char *buffers = (char *)allocAligned(
+      (size_t)(block_bytes * num_buffers), directReadAlignment);
+  if (buffers == nullptr) {
+    closeReadHandle(file);
+    return;
+  }
+
+  impl_ = new Impl();
+  impl_->file = file;
+  impl_->numBytes = num_bytes;
+  impl_->blockBytes = block_bytes;
+  impl_->numBlocks = divideRoundUp(num_bytes, block_bytes);
+  impl_->numBuffers = num_buffers;
+  impl_->buffers = buffers;
+  impl_->numRead = 0;
+  impl_->numReleased = 0;
+  impl_->current = -1;
+  impl_->readFailed = false;
+  impl_->stop = false;
+  impl_->checksum = Checksum(cfg.checksum);
+
+  impl_->thread = std::thread([impl = impl_]() { impl->readLoop(); });
+#else
+  (void)path;
+  (void)cfg;
+#endif
+}
+
+StreamReader::StreamReader(StreamReader &&o)
+  : impl_(o.impl_)
+{
+  o.impl_ = nullptr;
+}
+
+StreamReader::~StreamReader()
+{
+  close();
+}
+
+StreamReader & StreamReader::operator=(StreamReader &&o)
+{
+  close();
+
+  impl_ = o.impl_;
+  o.impl_ = nullptr;
+
+  return *this;
+}
+
+i64 StreamReader::size() const
+{
+#ifdef BRT_POSITIONAL_READS
+  return impl_ != nullptr ? impl_->numBytes : 0;
+#else
+  return 0;
+#endif
+}
+
+Span<const char> StreamReader::next()
+{
+#ifdef BRT_POSITIONAL_READS
+  if (impl_ == nullptr) {
+    return {};
+  }
+
+  Impl &impl = *impl_;
+  std::unique_lock guard(impl.lock);
+
+  if (impl.current >= 0 && impl.current == impl.numReleased) {
+    impl.numReleased++;
+    guard.unlock();
+    impl.releaseCV.notify_one();
+    guard.lock();
+  }
+
+  i64 block = impl.numReleased;
+  if (block >= impl.numBlocks) {
+    return {};
+  }
+
+  impl.readCV.wait(guard, [&]() {
+    return impl.numRead > block || impl.readFailed;
+  });
+
+  if (impl.numRead <= block) {
+    return {};
+  }
+
+  impl.current = block;
+
+  i64 offset = block * impl.blockBytes;
+  i64 num_bytes = impl.numBytes - offset;
+  if (num_bytes > impl.blockBytes) {
+    num_bytes = impl.blockBytes;
+  }
+
+  return {
+    impl.buffers + (block % impl.numBuffers) * impl.blockBytes,
+    num_bytes,
+  };
+#else
+  return {};
+#endif
+}
+
+i64 StreamReader::blockOffset() const
+{
+#ifdef BRT_POSITIONAL_READS
+  if (impl_ == nullptr || impl_->current < 0) {
+    return 0;
+  }
+
+  return impl_->current * impl_->blockBytes;
+#else
+  return 0;
+#endif
+}
+
+bool StreamReader::failed() const
+{
+#ifdef BRT_POSITIONAL_READS
+  if (impl_ == nullptr) {
+    return false;
+  }
+
+  std::lock_guard guard(impl_->lock);
+  return impl_->readFailed;
+#else
+  return false;
+#endif
+}
+
+u64 StreamReader::checksum() const
+{
+#ifdef BRT_POSITIONAL_READS
+  if (impl_ == nullptr) {
+    return 0;
+  }
+
+  std::lock_guard guard(impl_->lock);
+  return impl_->checksum.value();
+#else
+  return 0;
+#endif
+}
+
+void StreamReader::close()
+{
+  if (impl_ == nullptr) {
+    return;
+  }
+
+#ifdef BRT_POSITIONAL_READS
+  {
+    std::lock_guard guard(impl_->lock);
+    impl_->stop = true;
+  }
+  impl_->releaseCV.notify_one();
+  impl_->thread.join();
+
+  deallocAligned(impl_->buffers);
+  closeReadHandle(impl_->file);
+#endif
+
+  delete impl_;
+  impl_ = nullptr;
+}
+
+namespace {
+
+struct SyncRequest {
+  intptr_t file;
+  bool success;
+};
+
+// Makes the data of every file durable. Writeback is started on all files
+// before waiting on any, so the device sees the batch at once.
+void syncFiles(Span<SyncRequest * const> reqs)
+{
+#if defined(BRT_OS_LINUX)
+  for (SyncRequest *req : reqs) {
+    sync_file_range((int)req->file, 0, 0, SYNC_FILE_RANGE_WRITE);
+  }
+
+  for (SyncRequest *req : reqs) {
+    req->success = fdatasync((int)req->file) == 0;
+  }
+#elif defined(BRT_OS_MACOS)
+  // fsync doesn't flush the drive's cache. F_FULLFSYNC does, for every
+  // file at once, so only the last file in the batch needs it.
+  bool success = true;
+  for (i64 i = 0; i < reqs.size(); i++) {
+    SyncRequest *req = reqs[i];
+
+    if (i + 1 < reqs.size()) {
+      req->success = fsync((int)req->file) == 0;
+    } else {
+      req->success = fcntl((int)req->file, F_FULLFSYNC) == 0 ||
+        fsync((int)req->file) == 0;
+    }
+
+    success = success && req->success;
+  }
+
+  if (!success) {
+    for (SyncRequest *req : reqs) {
+      req->success = false;
+    }
+  }
+#elif defined(BRT_OS_WINDOWS)
+  for (SyncRequest *req : reqs) {
+    req->success = FlushFileBuffers((HANDLE)req->file);
+  }
+#else
+  for (SyncRequest *req : reqs) {
+    req->success = false;
+  }
+#endif
+}
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+bool writeAll(int fd, iovec *iovs, i64 num_iovs)
+{
+  while (num_iovs > 0) {
+    int batch_size = num_iovs < IOV_MAX ? (int)num_iovs : IOV_MAX;
+    ssize_t num_written = writev(fd, iovs, batch_size);
+    if (num_written < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (num_written <= 0) {
+      return false;
+    }
+
+    // Skip the fully written iovecs and trim a partially written one
+    size_t remaining = (size_t)num_written;
+    while (num_iovs > 0 && remaining >= iovs->iov_len) {
+      remaining -= iovs->iov_len;
+      iovs++;
+      num_iovs--;
+    }
+
+    if (num_iovs > 0) {
+      iovs->iov_base = (char *)iovs->iov_base + remaining;
+      iovs->iov_len -= remaining;
+    }
+  }
+
+  return true;
+}
+
+bool pwriteAll(int fd, const char *data, i64 num_bytes, i64 offset)
+{
+  while (num_bytes > 0) {
+    ssize_t num_written = pwrite(fd, data, (size_t)num_bytes, (off_t)offset);
+    if (num_written < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (num_written <= 0) {
+      return false;
+    }
+
+    data += num_written;
+    num_bytes -= num_written;
+    offset += num_written;
+  }
+
+  return true;
+}
+#elif defined(BRT_OS_WINDOWS)
+bool writeAll(HANDLE file, const char *data, i64 num_bytes, i64 offset)
+{
+  while (num_bytes > 0) {
+    DWORD write_size = num_bytes < (1 << 30) ? (DWORD)num_bytes : (1 << 30);
+
+    // A negative offset appends at the file pointer
+    OVERLAPPED overlapped {};
+    OVERLAPPED *position = nullptr;
+    if (offset >= 0) {
+      overlapped.Offset = (DWORD)offset;
+      overlapped.OffsetHigh = (DWORD)(offset >> 32);
+      position = &overlapped;
+    }
+
+    DWORD num_written;
+    if (!WriteFile(file, data, write_size, &num_written, position) ||
+        num_written == 0) {
+      return false;
+    }
+
+    data += num_written;
+    num_bytes -= num_written;
+    if (offset >= 0) {
+      offset += num_written;
+    }
+  }
+
+  return true;
+}
+#endif
+
+char * copyString(const char *str, i64 extra_bytes)
+{
+  size_t len = strlen(str);
+  char *copy = (char *)malloc(len + 1 + (size_t)extra_bytes);
+  memcpy(copy, str, len + 1);
+
+  return copy;
+}
+
+}
+
+struct WriteSyncGroup::Impl {
+  std::mutex lock;
+  std::condition_variable doneCV;
+  // Requests waiting for the next batch
+  SmallVec<SyncRequest *, 16> pending;
+  // Batch that new requests join, and the number of finished batches.
+  // Batch i is finished once numCompleted > i.
+  i64 openBatch;
+  i64 numCompleted;
+  bool syncing;
+};
+
+WriteSyncGroup::WriteSyncGroup()
+  : impl_(new Impl())
+{
+  impl_->openBatch = 0;
+  impl_->numCompleted = 0;
+  impl_->syncing = false;
+}
+
+WriteSyncGroup::~WriteSyncGroup()
+{
+  delete impl_;
+}
+
+i64 WriteSyncGroup::numBatches() const
+{
+  std::lock_guard guard(impl_->lock);
+  return impl_->numCompleted;
+}
+
+bool WriteSyncGroup::sync(intptr_t file)
+{
+  Impl &impl = *impl_;
+
+  SyncRequest req { file, false };
+
+  std::unique_lock guard(impl.lock);
+  i64 batch = impl.openBatch;
+  impl.pending.push(&req);
+
+  while (impl.numCompleted <= batch) {
+    if (impl.syncing) {
+      impl.doneCV.wait(guard);
+      continue;
+    }
+
+    // Nothing is in flight, so every earlier batch is done and this
+    // thread leads its own batch
+    impl.syncing = true;
+    impl.openBatch++;
+
+    SmallVec<SyncRequest *, 16> reqs;
+    for (SyncRequest *pending_req : impl.pending) {
+      reqs.push(pending_req);
+    }
+    impl.pending.clear();
+
+    guard.unlock();
+    syncFiles(Span<SyncRequest * const>(reqs.data(), reqs.size()));
+    guard.lock();
+
+    impl.numCompleted = batch + 1;
+    impl.syncing = false;
+    impl.doneCV.notify_all();
+  }
+
+  return req.success;
+}
+
+BinaryWriter::BinaryWriter()
+  : file_(-1),
+    buffer_(nullptr),
+    buffer_capacity_(0),
+    buffer_used_(0),
+    num_bytes_(0),
+    path_(nullptr),
+    tmp_path_(nullptr),
+    durability_(WriteDurability::None),
+    sync_group_(nullptr),
+    open_(false),
+    failed_(false)
+{}
+
+BinaryWriter::BinaryWriter(const char *path, const BinaryWriterConfig &cfg)
+  : BinaryWriter()
+{
+  chk(cfg.durability != WriteDurability::GroupCommit ||
+      cfg.syncGroup != nullptr);
+
+  durability_ = cfg.durability;
+  sync_group_ = cfg.syncGroup;
+
+  path_ = copyString(path, 0);
+
+  if (cfg.atomicReplace) {
+    static AtomicU32 tmp_counter(0);
+
+#if defined(BRT_OS_WINDOWS)
+    u32 pid = (u32)GetCurrentProcessId();
+#elif defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    u32 pid = (u32)getpid();
+#else
+    u32 pid = 0;
+#endif
+
+    constexpr i64 suffix_bytes = 32;
+    tmp_path_ = copyString(path, suffix_bytes);
+    size_t len = strlen(path);
+    snprintf(tmp_path_ + len, suffix_bytes + 1, ".tmp.%u.%u", pid,
+             tmp_counter.fetch_add_relaxed(1));
+  }
+
+  const char *open_path = tmp_path_ != nullptr ? tmp_path_ : path_;
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC |
+    (tmp_path_ != nullptr ? O_EXCL : O_TRUNC);
+  int fd = ::open(open_path, flags, 0666);
+  if (fd == -1) {
+    release();
+    return;
+  }
+
+  file_ = fd;
+#elif defined(BRT_OS_WINDOWS)
+  HANDLE file = CreateFileA(open_path, GENERIC_WRITE, 0, nullptr,
+                            tmp_path_ != nullptr ? CREATE_NEW : CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    release();
+    return;
+  }
+
+  file_ = (intptr_t)file;
+#else
+  (void)open_path;
+  release();
+  return;
+#endif
+
+  buffer_capacity_ = (i64)roundUpPow2(
+      cfg.bufferBytes > 0 ? (u64)cfg.bufferBytes : 1, directReadAlignment);
+  buffer_ = (char *)allocAligned((size_t)buffer_capacity_,
+                                 directReadAlignment);
+  if (buffer_ == nullptr) {
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    ::close((int)file_);
+    if (tmp_path_ != nullptr) {
+      unlink(tmp_path_);
+    }
+#elif defined(BRT_OS_WINDOWS)
+    CloseHandle((HANDLE)file_);
+    if (tmp_path_ != nullptr) {
+      DeleteFileA(tmp_path_);
+    }
+#endif
+
+    release();
+    return;
+  }
+
+  open_ = true;
+}
+
+BinaryWriter::BinaryWriter(BinaryWriter &&o)
+  : file_(o.file_),
+    buffer_(o.buffer_),
+    buffer_capacity_(o.buffer_capacity_),
+    buffer_used_(o.buffer_used_),
+    num_bytes_(o.num_bytes_),
+    path_(o.path_),
+    tmp_path_(o.tmp_path_),
+    durability_(o.durability_),
+    sync_group_(o.sync_group_),
+    open_(o.open_),
+    failed_(o.failed_)
+{
+  o.buffer_ = nullptr;
+  o.path_ = nullptr;
+  o.tmp_path_ = nullptr;
+  o.open_ = false;
+}
+
+BinaryWriter::~BinaryWriter()
+{
+  closeOnDestroy();
+}
+
+BinaryWriter & BinaryWriter::operator=(BinaryWriter &&o)
+{
+  closeOnDestroy();
+
+  file_ = o.file_;
+  buffer_ = o.buffer_;
+  buffer_capacity_ = o.buffer_capacity_;
+  buffer_used_ = o.buffer_used_;
+  num_bytes_ = o.num_bytes_;
+  path_ = o.path_;
+  tmp_path_ = o.tmp_path_;
+  durability_ = o.durability_;
+  sync_group_ = o.sync_group_;
+  open_ = o.open_;
+  failed_ = o.failed_;
+
+  o.buffer_ = nullptr;
+  o.path_ = nullptr;
+  o.tmp_path_ = nullptr;
+  o.open_ = false;
+
+  return *this;
+}
+
+bool BinaryWriter::write(Span<const char> data)
+{
+  if (!open_ || failed_) {
+    return false;
+  }
+
+  if (data.size() == 0) {
+    return true;
+  }
+
+  if (data.size() <= buffer_capacity_ - buffer_used_) {
+    memcpy(buffer_ + buffer_used_, data.data(), (size_t)data.size());
+    buffer_used_ += data.size();
+    num_bytes_ += data.size();
+    return true;
+  }
+
+  return flushWith(Span<const Span<const char>>(&data, 1));
+}
+
+bool BinaryWriter::write(Span<const Span<const char>> parts)
+{
+  if (!open_ || failed_) {
+    return false;
+  }
+
+  i64 total_bytes = 0;
+  for (Span<const char> part : parts) {
+    total_bytes += part.size();
+  }
+
+  if (total_bytes > buffer_capacity_ - buffer_used_) {
+    return flushWith(parts);
+  }
+
+  for (Span<const char> part : parts) {
+    if (part.size() > 0) {
+      memcpy(buffer_ + buffer_used_, part.data(), (size_t)part.size());
+      buffer_used_ += part.size();
+    }
+  }
+  num_bytes_ += total_bytes;
+
+  return true;
+}
+
+bool BinaryWriter::writeAt(i64 offset, Span<const char> data)
+{
+  chk(offset >= 0 && offset + data.size() <= num_bytes_);
+
+  if (!open_ || failed_) {
+    return false;
+  }
+
+  // The tail of the range may still be in the buffer
+  i64 flushed_bytes = num_bytes_ - buffer_used_;
+  i64 file_part = flushed_bytes - offset;
+  if (file_part < 0) {
+    file_part = 0;
+  } else if (file_part > data.size()) {
+    file_part = data.size();
+  }
+
+  if (file_part < data.size()) {
+    i64 buffer_offset = offset + file_part - flushed_bytes;
+    memcpy(buffer_ + buffer_offset, data.data() + file_part,
+           (size_t)(data.size() - file_part));
+  }
+
+  if (file_part == 0) {
+    return true;
+  }
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  bool success = pwriteAll((int)file_, data.data(), file_part, offset);
+#elif defined(BRT_OS_WINDOWS)
+  bool success = writeAll((HANDLE)file_, data.data(), file_part, offset);
+#else
+  bool success = false;
+#endif
+
+  failed_ = !success;
+  return success;
+}
+
+bool BinaryWriter::flush()
+{
+  if (!open_ || failed_) {
+    return false;
+  }
+
+  return flushWith({});
+}
+
+bool BinaryWriter::close()
+{
+  if (!open_) {
+    return false;
+  }
+
+  bool success = flush() && syncFile(file_);
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  success = ::close((int)file_) == 0 && success;
+#elif defined(BRT_OS_WINDOWS)
+  success = CloseHandle((HANDLE)file_) && success;
+#endif
+
+  if (tmp_path_ != nullptr) {
+    if (!success) {
+#if defined(BRT_OS_WINDOWS)
+      DeleteFileA(tmp_path_);
+#else
+      unlink(tmp_path_);
+#endif
+      release();
+      return false;
+    }
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+    success = rename(tmp_path_, path_) == 0;
+    if (!success) {
+      unlink(tmp_path_);
+    } else if (durability_ != WriteDurability::None) {
+      // The rename itself is only durable once the directory is synced
+      const char *slash = strrchr(path_, '/');
+      if (slash != nullptr) {
+        path_[slash == path_ ? 1 : slash - path_] = '\0';
+      }
+
+      int dir_fd = ::open(slash != nullptr ? path_ : ".",
+                          O_RDONLY | O_CLOEXEC | O_DIRECTORY);
+      success = dir_fd != -1 && syncFile(dir_fd);
+      if (dir_fd != -1) {
+        ::close(dir_fd);
+      }
+    }
+#elif defined(BRT_OS_WINDOWS)
+    success = MoveFileExA(tmp_path_, path_,
+                          MOVEFILE_REPLACE_EXISTING |
+                          MOVEFILE_WRITE_THROUGH);
+    if (!success) {
+      DeleteFileA(tmp_path_);
+    }
+#endif
+  }
+
+  release();
+  return success;
+}
+
+void BinaryWriter::abort()
+{
+  if (!open_) {
+    return;
+  }
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  ::close((int)file_);
+  if (tmp_path_ != nullptr) {
+    unlink(tmp_path_);
+  }
+#elif defined(BRT_OS_WINDOWS)
+  CloseHandle((HANDLE)file_);
+  if (tmp_path_ != nullptr) {
+    DeleteFileA(tmp_path_);
+  }
+#endif
+
+  release();
+}
+
+bool BinaryWriter::flushWith(Span<const Span<const char>> parts)
+{
+  Span<const char> buffered(buffer_, buffer_used_);
+  bool success = true;
+
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  constexpr i64 max_iovs = 64;
+  iovec iovs[max_iovs];
+  i64 num_iovs = 0;
+
+  auto addIOV = [&](Span<const char> data) {
+    if (data.size() == 0 || !success) {
+      return;
+    }
+
+    if (num_iovs == max_iovs) {
+      success = writeAll((int)file_, iovs, num_iovs);
+      num_iovs = 0;
+    }
+
+    iovs[num_iovs++] = { (void *)data.data(), (size_t)data.size() };
+  };
+
+  addIOV(buffered);
+  for (Span<const char> part : parts) {
+    addIOV(part);
+  }
+
+  if (success && num_iovs > 0) {
+    success = writeAll((int)file_, iovs, num_iovs);
+  }
+#elif defined(BRT_OS_WINDOWS)
+  success = writeAll((HANDLE)file_, buffered.data(), buffered.size(), -1);
+  for (i64 i = 0; success && i < parts.size(); i++) {
+    success = writeAll((HANDLE)file_, parts[i].data(), parts[i].size(), -1);
+  }
+#else
+  success = false;
+#endif
+
+  for (Span<const char> part : parts) {
+    num_bytes_ += part.size();
+  }
+  buffer_used_ = 0;
+  failed_ = !success;
+
+  return success;
+}
+
+bool BinaryWriter::syncFile(intptr_t file)
+{
+  switch (durability_) {
+    case WriteDurability::None: {
+      return true;
+    }
+    case WriteDurability::Sync: {
+      SyncRequest req { file, false };
+      SyncRequest *req_ptr = &req;
+      syncFiles(Span<SyncRequest * const>(&req_ptr, 1));
+      return req.success;
+    }
+    case WriteDurability::GroupCommit: {
+      return sync_group_->sync(file);
+    }
+  }
+
+  BRT_UNREACHABLE();
+}
+
+void BinaryWriter::closeOnDestroy()
+{
+  if (!open_) {
+    return;
+  }
+
+  if (tmp_path_ != nullptr) {
+    abort();
+  } else {
+    close();
+  }
+}
+
+void BinaryWriter::release()
+{
+  deallocAligned(buffer_);
+  free(path_);
+  free(tmp_path_);
+
+  buffer_ = nullptr;
+  path_ = nullptr;
+  tmp_path_ = nullptr;
+  buffer_capacity_ = 0;
+  buffer_used_ = 0;
+  open_ = false;
+}
+
+namespace {
+
+struct FileVersion {
+  i64 numBytes;
+  i64 mtimeNs;
+  u64 inode;
+  u64 device;
+};
+
+bool statFileVersion(const char *path, FileVersion *out)
+{
+#if defined(BRT_OS_LINUX) || defined(BRT_OS_MACOS)
+  struct stat file_stat;
+  if (stat(path, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+    return false;
+  }
+
+#if defined(BRT_OS_MACOS)
+  const timespec &mtime = file_stat.st_mtimespec;
+#else
+  const timespec &mtime = file_stat.st_mtim;
+#endif
+
+  out->numBytes = (i64)file_stat.st_size;
+  out->mtimeNs = (i64)mtime.tv_sec * 1000000000 + (i64)mtime.tv_nsec;
+  out->inode = (u64)file_stat.st_ino;
+  out->device = (u64)file_stat.st_dev;
+  return true;
+#elif defined(BRT_OS_WINDOWS)
+  // No inode without opening the file; the write time changes on replace
+  WIN32_FILE_ATTRIBUTE_DATA attrs;
+  if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attrs) ||
+      (attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    return false;
+  }
+
+  out->numBytes = ((i64)attrs.nFileSizeHigh << 32) | attrs.nFileSizeLow;
+  out->mtimeNs = (((i64)attrs.ftLastWriteTime.dwHighDateTime << 32) |
+                  attrs.ftLastWriteTime.dwLowDateTime) * 100;
+  out->inode = 0;
+  out->device = 0;
+  return true;
+#else
+  i64 num_bytes = fileSize(path);
+  if (num_bytes < 0) {
+    return false;
+  }
+
+  *out = { num_bytes, 0, 0, 0 };
+  return true;
+#endif
+}
+
+}
+
+struct FileCacheEntry {
+  // One reference while the entry is in the cache, plus one per handle and
+  // per thread waiting on the load
+  AtomicI64 refCount;
+
+  char *path;
+  u64 pathHash;
+  FileVersion version;
+
+  // Contents are either mapped or in heapData
+  MappedFile mapping;
+  char *heapData;
+  const char *data;
+  i64 loadedBytes;
+
+  bool loading;
+  bool failed;
+  bool cached;
+
+  FileCacheEntry *hashNext;
+  FileCacheEntry *lruPrev;
+  FileCacheEntry *lruNext;
+
+  FileCacheEntry()
+    : refCount(0),
+      path(nullptr),
+      pathHash(0),
+      version(),
+      mapping(),
+      heapData(nullptr),
+      data(nullptr),
+      loadedBytes(0),
+      loading(false),
+      failed(false),
+      cached(false),
+      hashNext(nullptr),
+      lruPrev(nullptr),
+      lruNext(nullptr)
+  {}
+
+  ~FileCacheEntry()
+  {
+    free(path);
+    deallocAligned(heapData);
+  }
+
+  bool load(i64 map_threshold)
+  {
+    if (version.numBytes >= map_threshold) {
+      mapping = MappedFile(path);
+      if (mapping.isOpen()) {
+        data = mapping.data().data();
+        loadedBytes = mapping.size();
+        return true;
+      }
+    }
+
+    size_t num_bytes;
+    heapData = readBinaryFile(path, 64, &num_bytes);
+    if (heapData == nullptr) {
+      return false;
+    }
+
+    data = heapData;
+    loadedBytes = (i64)num_bytes;
+    return true;
+  }
+
+  void release()
+  {
+    if (refCount.fetch_sub_acq_rel(1) == 1) {
+      delete this;
+    }
+  }
+};
+
+CachedFile::CachedFile()
+  : entry_(nullptr),
+    data_(nullptr),
+    num_bytes_(0)
+{}
+
+CachedFile::CachedFile(FileCacheEntry *entry)
+  : entry_(entry),
+    data_(entry->data),
+    num_bytes_(entry->loadedBytes)
+{}
+
+CachedFile::CachedFile(const CachedFile &o)
+  : entry_(o.entry_),
+    data_(o.data_),
+    num_bytes_(o.num_bytes_)
+{
+  if (entry_ != nullptr) {
+    entry_->refCount.fetch_add_relaxed(1);
+  }
+}
+
+CachedFile::CachedFile(CachedFile &&o)
+  : entry_(o.entry_),
+    data_(o.data_),
+    num_bytes_(o.num_bytes_)
+{
+  o.entry_ = nullptr;
+  o.data_ = nullptr;
+  o.num_bytes_ = 0;
+}
+
+CachedFile::~CachedFile()
+{
+  release();
+}
+
+CachedFile & CachedFile::operator=(const CachedFile &o)
+{
+  if (o.entry_ != nullptr) {
+    o.entry_->refCount.fetch_add_relaxed(1);
+  }
+
+  release();
+
+  entry_ = o.entry_;
+  data_ = o.data_;
+  num_bytes_ = o.num_bytes_;
+
+  return *this;
+}
+
+CachedFile & CachedFile::operator=(CachedFile &&o)
+{
+  release();
+
+  entry_ = o.entry_;
+  data_ = o.data_;
+  num_bytes_ = o.num_bytes_;
+
+  o.entry_ = nullptr;
+  o.data_ = nullptr;
+  o.num_bytes_ = 0;
+
+  return *this;
+}
+
+void CachedFile::release()
+{
+  if (entry_ != nullptr) {
+    entry_->release();
+    entry_ = nullptr;
+  }
+}
+
+struct FileCache::Impl {
+  FileCacheConfig cfg;
+
+  mutable std::mutex lock;
+  std::condition_variable loadedCV;
+
+  // Chained hash table of cached entries
+  FileCacheEntry **buckets;
+  u64 bucketMask;
+  i64 numEntries;
+
+  // Most recently used first
+  FileCacheEntry *lruHead;
+  FileCacheEntry *lruTail;
+
+  i64 residentBytes;
+  i64 numHits;
+  i64 numMisses;
+  i64 numReloads;
+  i64 numEvictions;
+
+  FileCacheEntry * find(const char *path, u64 path_hash) const
+  {
+    FileCacheEntry *entry = buckets[path_hash & bucketMask];
+    while (entry != nullptr) {
+      if (entry->pathHash == path_hash && strcmp(entry->path, path) == 0) {
+        return entry;
+      }
+
+      entry = entry->hashNext;
+    }
+
+    return nullptr;
+  }
+
+  void lruPushFront(FileCacheEntry *entry)
+  {
+    entry->lruPrev = nullptr;
+    entry->lruNext = lruHead;
+    if (lruHead != nullptr) {
+      lruHead->lruPrev = entry;
+    } else {
+      lruTail = entry;
+    }
+    lruHead = entry;
+  }
+
+  void lruUnlink(FileCacheEntry *entry)
+  {
+    if (entry->lruPrev != nullptr) {
+      entry->lruPrev->lruNext = entry->lruNext;
+    } else {
+      lruHead = entry->lruNext;
+    }
+
+    if (entry->lruNext != nullptr) {
+      entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+      lruTail = entry->lruPrev;
+    }
+  }
+
+  void insert(FileCacheEntry *entry)
+  {
+    if (numEntries >= (i64)bucketMask + 1) {
+      grow();
+    }
+
+    FileCacheEntry **bucket = &buckets[entry->pathHash & bucketMask];
+    entry->hashNext = *bucket;
+    *bucket = entry;
+
+    lruPushFront(entry);
+
+    entry->cached = true;
+    entry->refCount.fetch_add_relaxed(1);
+    numEntries++;
+  }
+
+  // Drops the cache's reference, which may free entry
+  void remove(FileCacheEntry *entry)
+  {
+    FileCacheEntry **link = &buckets[entry->pathHash & bucketMask];
+    while (*link != entry) {
+      link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+
+    lruUnlink(entry);
+
+    if (!entry->loading && !entry->failed) {
+      residentBytes -= entry->loadedBytes;
+    }
+
+    entry->cached = false;
+    numEntries--;
+
+    entry->release();
+  }
+
+  void grow()
+  {
+    u64 new_num_buckets = 2 * (bucketMask + 1);
+    auto *new_buckets = (FileCacheEntry **)calloc(
+        new_num_buckets, sizeof(FileCacheEntry *));
+
+    for (u64 i = 0; i <= bucketMask; i++) {
+      FileCacheEntry *entry = buckets[i];
+      while (entry != nullptr) {
+        FileCacheEntry *next = entry->hashNext;
+
+        FileCacheEntry **bucket =
+            &new_buckets[entry->pathHash & (new_num_buckets - 1)];
+        entry->hashNext = *bucket;
+        *bucket = entry;
+
+        entry = next;
+      }
+    }
+
+    free(buckets);
+    buckets = new_buckets;
+    bucketMask = new_num_buckets - 1;
+  }
+
+  // Evicts least recently used files that aren't referenced by a handle
+  // until the cache fits in its budget
+  void evict()
+  {
+    FileCacheEntry *entry = lruTail;
+    while (residentBytes > cfg.byteBudget && entry != nullptr) {
+      FileCacheEntry *prev = entry->lruPrev;
+
+      // Only get() adds references to an entry no handle refers to, and
+      // it holds the lock, so a count of 1 can't change under us
+      if (!entry->loading && entry->refCount.load_relaxed() == 1) {
+        remove(entry);
+        numEvictions++;
+      }
+
+      entry = prev;
+    }
+  }
+};
+
+FileCache::FileCache(const FileCacheConfig &cfg)
+  : impl_(new Impl())
+{
+  constexpr u64 init_num_buckets = 64;
+
+  impl_->cfg = cfg;
+  impl_->buckets = (FileCacheEntry **)calloc(
+      init_num_buckets, sizeof(FileCacheEntry *));
+  impl_->bucketMask = init_num_buckets - 1;
+  impl_->numEntries = 0;
+  impl_->lruHead = nullptr;
+  impl_->lruTail = nullptr;
+  impl_->residentBytes = 0;
+  impl_->numHits = 0;
+  impl_->numMisses = 0;
+  impl_->numReloads = 0;
+  impl_->numEvictions = 0;
+}
+
+FileCache::~FileCache()
+{
+  clear();
+
+  free(impl_->buckets);
+  delete impl_;
+}
+
+CachedFile FileCache::get(const char *path)
+{
+  Impl &impl = *impl_;
+
+  FileVersion version;
+  bool exists = statFileVersion(path, &version);
+
+  u64 path_hash = hash64(path, (i64)strlen(path));
+
+  std::unique_lock guard(impl.lock);
+
+  FileCacheEntry *entry = impl.find(path, path_hash);
+  if (entry != nullptr && exists &&
+      entry->version.numBytes == version.numBytes &&
+      entry->version.mtimeNs == version.mtimeNs &&
+      entry->version.inode == version.inode &&
+      entry->version.device == version.device) {
+    entry->refCount.fetch_add_relaxed(1);
+
+    if (entry->loading) {
+      impl.loadedCV.wait(guard, [&]() { return !entry->loading; });
+    }
+
+    if (entry->failed) {
+      impl.numMisses++;
+      guard.unlock();
+      entry->release();
+      return CachedFile();
+    }
+
+    impl.numHits++;
+    if (entry->cached) {
+      impl.lruUnlink(entry);
+      impl.lruPushFront(entry);
+    }
+
+    return CachedFile(entry);
+  }
+
+  impl.numMisses++;
+
+  if (entry != nullptr) {
+    impl.remove(entry);
+    impl.numReloads++;
+  }
+
+  if (!exists) {
+    return CachedFile();
+  }
+
+  size_t path_len = strlen(path);
+  entry = new FileCacheEntry();
+  entry->path = (char *)malloc(path_len + 1);
+  memcpy(entry->path, path, path_len + 1);
+  entry->pathHash = path_hash;
+  entry->version = version;
+  entry->loading = true;
+  // This thread's reference
+  entry->refCount.store_relaxed(1);
+
+  impl.insert(entry);
+
+  // Other threads asking for this file wait on the entry instead of
+  // issuing their own read
+  guard.unlock();
+  bool success = entry->load(impl.cfg.mapThreshold);
+  guard.lock();
+
+  entry->loading = false;
+  entry->failed = !success;
+
+  if (entry->cached) {
+    if (success) {
+      impl.residentBytes += entry->loadedBytes;
+      impl.evict();
+    } else {
+      impl.remove(entry);
+    }
+  }
+
+  impl.loadedCV.notify_all();
+  guard.unlock();
+
+  if (!success) {
+    entry->release();
+    return CachedFile();
+  }
+
+  return CachedFile(entry);
+}
+
+void FileCache::invalidate(const char *path)
+{
+  u64 path_hash = hash64(path, (i64)strlen(path));
+
+  std::lock_guard guard(impl_->lock);
+
+  FileCacheEntry *entry = impl_->find(path, path_hash);
+  if (entry != nullptr) {
+    impl_->remove(entry);
+  }
+}
+
+void FileCache::clear()
+{
+  std::lock_guard guard(impl_->lock);
+
+  while (impl_->lruHead != nullptr) {
+    impl_->remove(impl_->lruHead);
+  }
+}
+
+FileCacheStats FileCache::stats() const
+{
+  std::lock_guard guard(impl_->lock);
+
+  return FileCacheStats {
+    impl_->numHits,
+    impl_->numMisses,
+    impl_->numReloads,
+    impl_->numEvictions,
+    impl_->numEntries,
+    impl_->residentBytes,
+  };
+}
+
+FileCache & globalFileCache()
+{
+  static FileCache cache;
+  return cache;
 }
 
 }
@@ -2,11 +2,389 @@
 
 #include <brt/types.hpp>
 #include <brt/span.hpp>
+#include <brt/checksum.hpp>
+#include <brt/stack_alloc.hpp>
 
 namespace brt {
 
+// Block size of the reads that feed a Checksum while the data is in cache
+inline constexpr i64 checksumBlockBytes = 256 * 1024;
+
+// Reads the whole file into a buffer aligned to buffer_alignment (a power
+// of two) and padded to a multiple of it. Returns nullptr on failure.
+// Free the buffer with deallocAligned.
+//
+// If checksum isn't null, the file is read in checksumBlockBytes blocks
+// that are fed to checksum right after each read, while they're still in
+// cache, instead of in a second pass over the whole buffer.
+char * readBinaryFile(const char *path,
+                      size_t buffer_alignment,
+                      size_t *out_num_bytes,
+                      Checksum *checksum = nullptr);
+
+// Reads the whole file into memory allocated from arena, which is left
+// unchanged on failure. Saves the heap allocation and free for short lived
+// loads, and keeps the data next to whatever is built from it.
 char * readBinaryFile(const char *path,
+                      StackAlloc &arena,
                       size_t buffer_alignment,
-                      size_t *out_num_bytes);
+                      size_t *out_num_bytes,
+                      Checksum *checksum = nullptr);
+
+// Reads the whole file into dst. Returns false if the file can't be read
+// or is larger than dst; use fileSize to size dst up front.
+bool readBinaryFile(const char *path,
+                    Span<char> dst,
+                    size_t *out_num_bytes,
+                    Checksum *checksum = nullptr);
+
+// Size of the file at path in bytes, or -1 if it doesn't exist
+i64 fileSize(const char *path);
+
+// Like readBinaryFile, but bypasses the page cache (O_DIRECT on Linux,
+// F_NOCACHE on macOS, unbuffered reads on Windows) so reading huge files
+// doesn't evict the rest of the working set. Reads are issued in
+// directReadBlockBytes blocks into a buffer aligned to at least
+// directReadAlignment. Falls back to buffered reads if the file system
+// doesn't support direct I/O.
+inline constexpr size_t directReadAlignment = 4096;
+inline constexpr size_t directReadBlockBytes = 8 * 1024 * 1024;
+
+char * readBinaryFileDirect(const char *path,
+                            size_t buffer_alignment,
+                            size_t *out_num_bytes);
+
+struct ParallelReadConfig {
+  // Threads issuing reads. Each thread has one read in flight at a time,
+  // so this is also the queue depth seen by the device.
+  i32 numThreads = 8;
+  // Bytes per read, rounded up to a multiple of directReadAlignment.
+  // Threads claim chunks in file order as they finish their previous one.
+  i64 chunkBytes = 4 * 1024 * 1024;
+  // Bypass the page cache, as in readBinaryFileDirect
+  bool direct = false;
+};
+
+struct ParallelReadStats {
+  i64 numBytes;
+  double seconds;
+  double gbPerSec;
+};
+
+// Like readBinaryFile, but splits the file into chunkBytes ranges that are
+// read concurrently with pread from numThreads threads into one buffer
+// aligned to at least directReadAlignment. A single sequential reader
+// leaves most of an NVMe drive's bandwidth unused. If out_stats isn't null
+// it receives the wall time and throughput of the whole call.
+char * readBinaryFileParallel(const char *path,
+                              size_t buffer_alignment,
+                              size_t *out_num_bytes,
+                              const ParallelReadConfig &cfg = {},
+                              ParallelReadStats *out_stats = nullptr);
+
+// Read only view of a whole file through the virtual memory system. Pages
+// are loaded on first access instead of being copied up front, and stay
+// shared with the page cache. CopyOnWrite mappings may be written through
+// mutableData(); writes are private to the process and never reach the
+// file. The file must not be truncated while it is mapped.
+class MappedFile {
+public:
+  enum class Mode : u32 {
+    ReadOnly,
+    CopyOnWrite,
+  };
+
+  enum class Advice : u32 {
+    Normal,
+    Sequential,
+    Random,
+    WillNeed,
+    // Back the mapping with transparent huge pages where the OS and file
+    // system support it
+    HugePage,
+  };
+
+  MappedFile();
+  // Check isOpen() for failure
+  MappedFile(const char *path, Mode mode = Mode::ReadOnly);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile(MappedFile &&o);
+  ~MappedFile();
+
+  MappedFile & operator=(const MappedFile &) = delete;
+  MappedFile & operator=(MappedFile &&o);
+
+  // Empty files are open with a null, 0 byte view
+  inline bool isOpen() const { return open_; }
+  inline i64 size() const { return num_bytes_; }
+
+  inline Span<const char> data() const { return { data_, num_bytes_ }; }
+  Span<char> mutableData() const;
+
+  // Hints the expected access pattern for [offset, offset + num_bytes),
+  // or the rest of the file if num_bytes is -1. Returns false if the hint
+  // was rejected; hints don't affect correctness.
+  bool advise(Advice advice, i64 offset = 0, i64 num_bytes = -1) const;
+
+  // Feeds [offset, offset + num_bytes), or the rest of the file, to
+  // checksum in checksumBlockBytes blocks while asking the OS to read ahead
+  // of the block being checksummed. Faults the range in as a side effect.
+  void checksum(Checksum &checksum, i64 offset = 0,
+                i64 num_bytes = -1) const;
+
+  void close();
+
+private:
+  char *data_;
+  i64 num_bytes_;
+  Mode mode_;
+  bool open_;
+};
+
+struct StreamReaderConfig {
+  // Bytes per block, rounded up to a multiple of directReadAlignment
+  i64 blockBytes = 2 * 1024 * 1024;
+  // Blocks held in memory at once: the caller's current block plus up to
+  // numBuffers - 1 blocks read ahead. At least 2.
+  i32 numBuffers = 2;
+  // Bypass the page cache, as in readBinaryFileDirect
+  bool direct = false;
+  // Checksum computed on the helper thread right after each block is read
+  ChecksumType checksum = ChecksumType::None;
+};
+
+// Reads a file front to back in fixed size blocks so processing can start
+// before the file is loaded and memory stays bounded by
+// numBuffers * blockBytes. A helper thread reads the following blocks
+// while the caller works on the current one.
+class StreamReader {
+public:
+  StreamReader();
+  // Check isOpen() for failure
+  StreamReader(const char *path, const StreamReaderConfig &cfg = {});
+  StreamReader(const StreamReader &) = delete;
+  StreamReader(StreamReader &&o);
+  ~StreamReader();
+
+  StreamReader & operator=(const StreamReader &) = delete;
+  StreamReader & operator=(StreamReader &&o);
+
+  inline bool isOpen() const { return impl_ != nullptr; }
+  // Size of the whole file
+  i64 size() const;
+
+  // Returns the next block, aligned to directReadAlignment. The previous
+  // block is released and must no longer be accessed. Returns an empty
+  // span at the end of the file or after a read error.
+  Span<const char> next();
+
+  // File offset of the block last returned by next()
+  i64 blockOffset() const;
+  // True if a read failed; the stream ends early
+  bool failed() const;
+  // Checksum of the whole file, of the configured type. Only valid once
+  // next() has returned an empty span and failed() is false.
+  u64 checksum() const;
+
+  void close();
+
+  struct Impl;
+
+private:
+  Impl *impl_;
+};
+
+enum class WriteDurability : u32 {
+  // Leave writeback to the OS; a crash may lose recent writes
+  None,
+  // fdatasync the file (and the directory after an atomic replace) at close
+  Sync,
+  // Like Sync, but through a WriteSyncGroup shared with other writers
+  GroupCommit,
+};
+
+// Batches the syncs of BinaryWriters closed concurrently. A writer that
+// closes while a sync is running waits for the next one, which covers every
+// writer that arrived in the meantime, so N concurrent closes cost about
+// one device flush instead of N. Must outlive its writers.
+class WriteSyncGroup {
+public:
+  WriteSyncGroup();
+  WriteSyncGroup(const WriteSyncGroup &) = delete;
+  ~WriteSyncGroup();
+
+  WriteSyncGroup & operator=(const WriteSyncGroup &) = delete;
+
+  // Sync batches issued so far
+  i64 numBatches() const;
+
+  struct Impl;
+
+private:
+  friend class BinaryWriter;
+
+  // Blocks until file's data is durable
+  bool sync(intptr_t file);
+
+  Impl *impl_;
+};
+
+struct BinaryWriterConfig {
+  // Size of the aligned write buffer. Writes that don't fit are issued
+  // together with the buffered bytes in one gathering write.
+  i64 bufferBytes = 1024 * 1024;
+  // Write to a temporary file next to path and rename it over path in
+  // close(), so readers see either the old or the complete new file
+  bool atomicReplace = true;
+  WriteDurability durability = WriteDurability::None;
+  // Required for WriteDurability::GroupCommit
+  WriteSyncGroup *syncGroup = nullptr;
+};
+
+// Buffered sequential file writer. Errors are sticky: once a write fails,
+// later calls return false. An atomicReplace writer's close() then
+// discards the file; other writers have already truncated the destination
+// and leave it partially written.
+class BinaryWriter {
+public:
+  BinaryWriter();
+  // Check isOpen() for failure
+  BinaryWriter(const char *path, const BinaryWriterConfig &cfg = {});
+  BinaryWriter(const BinaryWriter &) = delete;
+  BinaryWriter(BinaryWriter &&o);
+  // Calls close(), except that an atomicReplace writer that was never
+  // closed is aborted and leaves the original file untouched
+  ~BinaryWriter();
+
+  BinaryWriter & operator=(const BinaryWriter &) = delete;
+  BinaryWriter & operator=(BinaryWriter &&o);
+
+  inline bool isOpen() const { return open_; }
+  inline bool failed() const { return failed_; }
+  // Bytes written so far, including buffered bytes
+  inline i64 size() const { return num_bytes_; }
+
+  bool write(Span<const char> data);
+  // Appends every part in order, gathering them into as few writev calls
+  // as possible when they don't fit in the buffer
+  bool write(Span<const Span<const char>> parts);
+  // Overwrites already written bytes at offset, e.g. to patch a header once
+  // section sizes are known. offset + data.size() must be at most size().
+  bool writeAt(i64 offset, Span<const char> data);
+
+  // Hands buffered bytes to the OS
+  bool flush();
+  // Flushes, applies the durability mode and, for atomicReplace, renames
+  // the temporary file over the destination. Returns false if any step or
+  // earlier write failed, in which case an atomicReplace writer leaves the
+  // destination unchanged; other writers leave it partially written.
+  bool close();
+  // Closes without committing; atomicReplace writers delete their
+  // temporary file
+  void abort();
+
+private:
+  bool flushWith(Span<const Span<const char>> parts);
+  bool syncFile(intptr_t file);
+  void closeOnDestroy();
+  void release();
+
+  // fd, or a HANDLE on Windows
+  intptr_t file_;
+  char *buffer_;
+  i64 buffer_capacity_;
+  i64 buffer_used_;
+  i64 num_bytes_;
+  // Destination path, and the temporary file for atomicReplace writers
+  char *path_;
+  char *tmp_path_;
+  WriteDurability durability_;
+  WriteSyncGroup *sync_group_;
+  bool open_;
+  bool failed_;
+};
+
+struct FileCacheEntry;
+
+// Shared, read only reference to a file held by a FileCache. The contents
+// stay valid while any copy of the handle exists, even after the cache
+// evicts or reloads the file.
+class CachedFile {
+public:
+  CachedFile();
+  CachedFile(const CachedFile &o);
+  CachedFile(CachedFile &&o);
+  ~CachedFile();
+
+  CachedFile & operator=(const CachedFile &o);
+  CachedFile & operator=(CachedFile &&o);
+
+  // False for handles returned by failed lookups
+  inline bool isValid() const { return entry_ != nullptr; }
+  inline Span<const char> data() const { return { data_, num_bytes_ }; }
+  inline i64 size() const { return num_bytes_; }
+
+private:
+  CachedFile(FileCacheEntry *entry);
+  void release();
+
+  FileCacheEntry *entry_;
+  const char *data_;
+  i64 num_bytes_;
+
+  friend class FileCache;
+};
+
+struct FileCacheConfig {
+  // Bytes of file contents the cache keeps resident. Files still
+  // referenced by a CachedFile aren't evicted, so the budget can be
+  // exceeded while they're in use.
+  i64 byteBudget = 256 * 1024 * 1024;
+  // Files at least this large are memory mapped, smaller files are read
+  // into heap buffers to avoid wasting the rest of a page
+  i64 mapThreshold = 64 * 1024;
+};
+
+struct FileCacheStats {
+  i64 hits;
+  i64 misses;
+  // Misses on cached files that had changed on disk
+  i64 reloads;
+  i64 evictions;
+  i64 numFiles;
+  i64 numBytes;
+};
+
+// Thread safe cache of whole files keyed by path. Every lookup stats the
+// file and reloads it if its size, modification time or inode changed, so
+// files replaced through a rename (BinaryWriter's atomicReplace) are always
+// seen whole. Concurrent lookups of a file that isn't cached share a single
+// read. Least recently used files are evicted to stay within byteBudget.
+class FileCache {
+public:
+  FileCache(const FileCacheConfig &cfg = {});
+  FileCache(const FileCache &) = delete;
+  ~FileCache();
+
+  FileCache & operator=(const FileCache &) = delete;
+
+  // Returns an invalid handle if the file can't be read
+  CachedFile get(const char *path);
+
+  // Drops path, or every file, from the cache. Outstanding handles stay
+  // valid.
+  void invalidate(const char *path);
+  void clear();
+
+  FileCacheStats stats() const;
+
+  struct Impl;
+
+private:
+  Impl *impl_;
+};
+
+// Process wide cache with the default configuration
+FileCache & globalFileCache();
 
 }
@@ -0,0 +1,346 @@
+#include <brt/lz4.hpp>
+#include <brt/err.hpp>
+#include <brt/macros.hpp>
+
+#include <bit>
+#include <cstring>
+
+namespace brt {
+
+namespace {
+
+constexpr i64 min_match = 4;
+// The format requires the last 5 bytes to be literals and the last match
+// to start at least 12 bytes before the end of the input
+constexpr i64 last_literals = 5;
+constexpr i64 match_start_limit = 12;
+constexpr i64 max_offset = 65535;
+
+constexpr i32 hash_log = 12;
+constexpr i32 hash_size = 1 << hash_log;
+
+// Compression skips ahead faster the longer it goes without a match
+constexpr i32 skip_trigger = 6;
+
+BRT_ALWAYS_INLINE inline u32 read32(const u8 *p)
+{
+    u32 v;
+    memcpy(&v, p, sizeof(u32));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline u64 read64(const u8 *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(u64));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline u32 hashSequence(u32 seq)
+{
+    return (seq * 2654435761u) >> (32 - hash_log);
+}
+
+BRT_ALWAYS_INLINE inline i64 matchLength(const u8 *a, const u8 *b,
+                                         const u8 *a_limit)
+{
+    const u8 *start = a;
+
+    while (a + 8 <= a_limit) {
+        u64 diff = read64(a) ^ read64(b);
+        if (diff != 0) {
+            return (a - start) + (std::countr_zero(diff) >> 3);
+        }
+
+        a += 8;
+        b += 8;
+    }
+
+    while (a < a_limit && *a == *b) {
+        a++;
+        b++;
+    }
+
+    return a - start;
+}
+
+BRT_ALWAYS_INLINE inline u8 * writeLength(u8 *op, i64 len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (u8)len;
+
+    return op;
+}
+
+u8 * writeSequence(u8 *op, const u8 *literals, i64 num_literals,
+                   i64 offset, i64 match_len)
+{
+    u8 *token = op++;
+
+    if (num_literals >= 15) {
+        *token = 15 << 4;
+        op = writeLength(op, num_literals - 15);
+    } else {
+        *token = (u8)(num_literals << 4);
+    }
+
+    if (num_literals > 0) {
+        memcpy(op, literals, (size_t)num_literals);
+        op += num_literals;
+    }
+
+    if (match_len == 0) {
+        return op;
+    }
+
+    op[0] = (u8)offset;
+    op[1] = (u8)(offset >> 8);
+    op += 2;
+
+    i64 len_code = match_len - min_match;
+    if (len_code >= 15) {
+        *token |= 15;
+        op = writeLength(op, len_code - 15);
+    } else {
+        *token |= (u8)len_code;
+    }
+
+    return op;
+}
+
+// Copies [src, src + num_bytes) in 16 byte steps, possibly writing up to
+// 15 bytes past dst + num_bytes
+BRT_ALWAYS_INLINE inline void wildCopy16(u8 *dst, const u8 *src,
+                                         i64 num_bytes)
+{
+    u8 *end = dst + num_bytes;
+    do {
+        memcpy(dst, src, 16);
+        dst += 16;
+        src += 16;
+    } while (dst < end);
+}
+
+// Copies a match whose source overlaps its destination (offset < 16),
+// possibly writing up to 15 bytes past dst + num_bytes. The first 8 bytes
+// are copied so that the remaining distance is at least 8, after which
+// 8 byte moves repeat the pattern correctly.
+BRT_ALWAYS_INLINE inline void wildCopyOverlap(u8 *dst, const u8 *src,
+                                              i64 offset, i64 num_bytes)
+{
+    static constexpr i32 inc[8] = { 0, 1, 2, 1, 0, 4, 4, 4 };
+    static constexpr i32 dec[8] = { 0, 0, 0, -1, -4, 1, 2, 3 };
+
+    u8 *end = dst + num_bytes;
+
+    if (offset < 8) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = src[3];
+        src += inc[offset];
+        memcpy(dst + 4, src, 4);
+        src -= dec[offset];
+    } else {
+        memcpy(dst, src, 8);
+        src += 8;
+    }
+    dst += 8;
+
+    while (dst < end) {
+        memcpy(dst, src, 8);
+        dst += 8;
+        src += 8;
+    }
+}
+
+}
+
+i64 lz4Compress(Span<const char> src, Span<char> dst)
+{
+    chk(dst.size() >= lz4CompressBound(src.size()));
+
+    const u8 *base = (const u8 *)src.data();
+    const i64 len = src.size();
+    u8 *op = (u8 *)dst.data();
+
+    const u8 *anchor = base;
+
+    if (len > match_start_limit) {
+        u32 table[hash_size] = {};
+
+        const u8 *match_limit = base + len - match_start_limit;
+        const u8 *match_end_limit = base + len - last_literals;
+
+        const u8 *ip = base + 1;
+
+        while (ip < match_limit) {
+            // Find the next match
+            const u8 *ref;
+            i32 attempts = 1 << skip_trigger;
+            while (true) {
+                u32 seq = read32(ip);
+                u32 h = hashSequence(seq);
+                ref = base + table[h];
+                table[h] = (u32)(ip - base);
+
+                if (ip - ref <= max_offset && ref < ip &&
+                    read32(ref) == seq) {
+                    break;
+                }
+
+                ip += attempts++ >> skip_trigger;
+                if (ip >= match_limit) {
+                    goto last_sequence;
+                }
+            }
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            i64 match_len = min_match + matchLength(
+                ip + min_match, ref + min_match, match_end_limit);
+
+            op = writeSequence(op, anchor, ip - anchor, ip - ref, match_len);
+
+            ip += match_len;
+            anchor = ip;
+
+            if (ip < match_limit) {
+                table[hashSequence(read32(ip - 2))] = (u32)(ip - 2 - base);
+            }
+        }
+    }
+
+last_sequence:
+    op = writeSequence(op, anchor, base + len - anchor, 0, 0);
+
+    return op - (u8 *)dst.data();
+}
+
+i64 lz4Decompress(Span<const char> src, Span<char> dst)
+{
+    const u8 *ip = (const u8 *)src.data();
+    const u8 *ip_end = ip + src.size();
+    u8 *op = (u8 *)dst.data();
+    u8 *op_start = op;
+    u8 *op_end = op + dst.size();
+
+    while (true) {
+        // Streams end with a literal only sequence, never after a match
+        if (ip == ip_end) [[unlikely]] {
+            return -1;
+        }
+
+        u8 token = *ip++;
+        i64 num_literals = token >> 4;
+        i64 offset;
+        i64 match_len;
+
+        // Short sequences dominate most inputs. When the buffers have slack
+        // they're copied with fixed size moves and no length checks.
+        if (num_literals != 15 && ip_end - ip >= 18 && op_end - op >= 32)
+            [[likely]] {
+            memcpy(op, ip, 16);
+            ip += num_literals;
+            op += num_literals;
+
+            offset = (i64)ip[0] | ((i64)ip[1] << 8);
+            ip += 2;
+            match_len = token & 15;
+
+            if (match_len != 15 && offset >= 8 && offset <= op - op_start) {
+                const u8 *ref = op - offset;
+                memcpy(op, ref, 8);
+                memcpy(op + 8, ref + 8, 8);
+                memcpy(op + 16, ref + 16, 2);
+                op += match_len + min_match;
+                continue;
+            }
+        } else {
+            if (num_literals == 15) {
+                u8 b;
+                do {
+                    if (ip == ip_end) [[unlikely]] {
+                        return -1;
+                    }
+
+                    b = *ip++;
+                    num_literals += b;
+                } while (b == 255);
+            }
+
+            if (num_literals > ip_end - ip || num_literals > op_end - op)
+                [[unlikely]] {
+                return -1;
+            }
+
+            if (ip_end - ip >= num_literals + 16 &&
+                op_end - op >= num_literals + 16) {
+                wildCopy16(op, ip, num_literals);
+            } else if (num_literals > 0) {
+                memmove(op, ip, (size_t)num_literals);
+            }
+            ip += num_literals;
+            op += num_literals;
+
+            // The last sequence has no match
+            if (ip == ip_end) {
+                break;
+            }
+
+            if (ip_end - ip < 2) [[unlikely]] {
+                return -1;
+            }
+
+            offset = (i64)ip[0] | ((i64)ip[1] << 8);
+            ip += 2;
+            match_len = token & 15;
+        }
+
+        if (offset == 0 || offset > op - op_start) [[unlikely]] {
+            return -1;
+        }
+
+        if (match_len == 15) {
+            u8 b;
+            do {
+                if (ip == ip_end) [[unlikely]] {
+                    return -1;
+                }
+
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += min_match;
+
+        if (match_len > op_end - op) [[unlikely]] {
+            return -1;
+        }
+
+        const u8 *ref = op - offset;
+        if (op_end - op >= match_len + 16) [[likely]] {
+            if (offset >= 16) {
+                wildCopy16(op, ref, match_len);
+            } else {
+                wildCopyOverlap(op, ref, offset, match_len);
+            }
+        } else {
+            // Overlapping copies repeat the last offset bytes
+            for (i64 i = 0; i < match_len; i++) {
+                op[i] = ref[i];
+            }
+        }
+        op += match_len;
+    }
+
+    return op - op_start;
+}
+
+}
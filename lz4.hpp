@@ -0,0 +1,27 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// Byte oriented LZ77 codec producing the LZ4 block format, so its output
+// can be inspected and decoded with standard LZ4 tools. Compression is
+// greedy with a single hash table probe per position; decompression
+// bounds checks every sequence and is safe on untrusted input.
+
+// Largest possible compressed size of num_bytes of input
+constexpr inline i64 lz4CompressBound(i64 num_bytes)
+{
+    return num_bytes + num_bytes / 255 + 16;
+}
+
+// Compresses src into dst, which must hold at least
+// lz4CompressBound(src.size()) bytes. Returns the compressed size.
+i64 lz4Compress(Span<const char> src, Span<char> dst);
+
+// Decompresses src into dst. Returns the decompressed size, or -1 if src
+// is malformed or decompresses to more than dst.size() bytes.
+i64 lz4Decompress(Span<const char> src, Span<char> dst);
+
+}
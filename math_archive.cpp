@@ -0,0 +1,249 @@
+#include <brt/math_archive.hpp>
+#include <brt/err.hpp>
+#include <brt/utils.hpp>
+
+#include <cstring>
+
+namespace brt {
+
+namespace {
+
+constexpr i64 elemBytesForType(MathArchiveType type)
+{
+    switch (type) {
+        case MathArchiveType::Vector3: return sizeof(Vector3);
+        case MathArchiveType::Quat: return sizeof(Quat);
+        case MathArchiveType::AABB: return sizeof(AABB);
+        case MathArchiveType::Mat3x4: return sizeof(Mat3x4);
+    }
+
+    return 0;
+}
+
+// Checks that the target of the RelPtr at field_offset in the archive,
+// num_bytes long, lies inside [0, archive_bytes)
+bool relTargetInBounds(i64 field_offset, i64 rel_offset, i64 num_bytes,
+                       i64 archive_bytes, i64 alignment)
+{
+    if (rel_offset < -field_offset ||
+        rel_offset > archive_bytes - field_offset) {
+        return false;
+    }
+
+    i64 target = field_offset + rel_offset;
+    return num_bytes <= archive_bytes - target &&
+        (target & (alignment - 1)) == 0;
+}
+
+}
+
+const MathArchive * MathArchive::view(Span<const char> data)
+{
+    if (data.size() < (i64)sizeof(MathArchive) ||
+        ((uintptr_t)data.data() & (mathArchiveAlignment - 1)) != 0) {
+        return nullptr;
+    }
+
+    const auto *archive = (const MathArchive *)data.data();
+    if (archive->magic != mathArchiveMagic ||
+        archive->version != mathArchiveVersion ||
+        archive->layoutHash != mathArchiveLayoutHash() ||
+        archive->numBytes < (i64)sizeof(MathArchive) ||
+        archive->numBytes > data.size()) {
+        return nullptr;
+    }
+
+    i64 archive_bytes = archive->numBytes;
+
+    i64 num_sections = archive->sections.size;
+    if (num_sections < 0 ||
+        num_sections > archive_bytes / (i64)sizeof(MathArchiveSection)) {
+        return nullptr;
+    }
+
+    // Empty spans must be null so get() never forms an out of bounds
+    // pointer
+    if (num_sections == 0) {
+        return archive->sections.data.isNull() ? archive : nullptr;
+    }
+
+    if (!relTargetInBounds(
+            offsetof(MathArchive, sections), archive->sections.data.offset,
+            num_sections * sizeof(MathArchiveSection),
+            archive_bytes, alignof(MathArchiveSection))) {
+        return nullptr;
+    }
+
+    const char *base = data.data();
+    Span<const MathArchiveSection> table = archive->sectionTable();
+    for (i64 i = 0; i < num_sections; i++) {
+        const MathArchiveSection &section = table[i];
+
+        i64 elem_bytes = elemBytesForType(section.type);
+        if (elem_bytes == 0 || section.elemBytes != elem_bytes) {
+            return nullptr;
+        }
+
+        i64 num_bytes = section.elems.size;
+        if (num_bytes < 0 || num_bytes % elem_bytes != 0) {
+            return nullptr;
+        }
+
+        if (num_bytes == 0) {
+            if (!section.elems.data.isNull()) {
+                return nullptr;
+            }
+
+            continue;
+        }
+
+        i64 field_offset = (const char *)&section.elems.data - base;
+        if (!relTargetInBounds(field_offset, section.elems.data.offset,
+                               num_bytes, archive_bytes,
+                               mathArchiveAlignment)) {
+            return nullptr;
+        }
+    }
+
+    return archive;
+}
+
+MathArchiveBuilder::MathArchiveBuilder()
+    : sections_(),
+      data_bytes_(0)
+{}
+
+void MathArchiveBuilder::addSection(u32 id, MathArchiveType type,
+                                    u32 elem_bytes, const void *data,
+                                    i64 num_elems)
+{
+    for (const PendingSection &section : sections_) {
+        chk(section.id != id);
+    }
+
+    i64 data_offset = roundToAlignment(data_bytes_, mathArchiveAlignment);
+    i64 num_bytes = num_elems * (i64)elem_bytes;
+
+    sections_.push(PendingSection {
+        id,
+        type,
+        elem_bytes,
+        (const char *)data,
+        num_bytes,
+        data_offset,
+    });
+
+    data_bytes_ = data_offset + num_bytes;
+}
+
+i64 MathArchiveBuilder::dataStart() const
+{
+    return roundToAlignment(
+        (i64)sizeof(MathArchive) +
+            sections_.size() * (i64)sizeof(MathArchiveSection),
+        mathArchiveAlignment);
+}
+
+i64 MathArchiveBuilder::numBytes() const
+{
+    return dataStart() + data_bytes_;
+}
+
+MathArchive MathArchiveBuilder::header() const
+{
+    MathArchive header {};
+    header.magic = mathArchiveMagic;
+    header.version = mathArchiveVersion;
+    header.layoutHash = mathArchiveLayoutHash();
+    header.numBytes = numBytes();
+
+    // The section table directly follows the header
+    header.sections.data.offset = sections_.isEmpty() ? 0 :
+        (i64)sizeof(MathArchive) - (i64)offsetof(MathArchive, sections);
+    header.sections.size = sections_.size();
+
+    return header;
+}
+
+MathArchiveSection MathArchiveBuilder::tableEntry(i64 section_idx) const
+{
+    const PendingSection &pending = sections_[section_idx];
+
+    i64 field_offset = (i64)sizeof(MathArchive) +
+        section_idx * (i64)sizeof(MathArchiveSection) +
+        (i64)offsetof(MathArchiveSection, elems);
+
+    MathArchiveSection section {};
+    section.id = pending.id;
+    section.type = pending.type;
+    section.elemBytes = pending.elemBytes;
+    section.elems.data.offset = pending.numBytes == 0 ? 0 :
+        dataStart() + pending.dataOffset - field_offset;
+    section.elems.size = pending.numBytes;
+
+    return section;
+}
+
+void MathArchiveBuilder::serialize(Span<char> dst) const
+{
+    i64 num_bytes = numBytes();
+    chk(dst.size() >= num_bytes);
+    chk(((uintptr_t)dst.data() & (mathArchiveAlignment - 1)) == 0);
+
+    char *base = dst.data();
+    memset(base, 0, (size_t)dataStart());
+
+    MathArchive archive = header();
+    memcpy(base, &archive, sizeof(MathArchive));
+
+    i64 data_start = dataStart();
+    i64 cur_offset = data_start;
+    for (i64 i = 0; i < sections_.size(); i++) {
+        MathArchiveSection section = tableEntry(i);
+        memcpy(base + sizeof(MathArchive) + i * sizeof(MathArchiveSection),
+               &section, sizeof(MathArchiveSection));
+
+        const PendingSection &pending = sections_[i];
+        i64 section_offset = data_start + pending.dataOffset;
+
+        memset(base + cur_offset, 0, section_offset - cur_offset);
+        if (pending.numBytes > 0) {
+            memcpy(base + section_offset, pending.data, pending.numBytes);
+        }
+        cur_offset = section_offset + pending.numBytes;
+    }
+}
+
+bool MathArchiveBuilder::write(const char *path,
+                               const BinaryWriterConfig &cfg) const
+{
+    BinaryWriter writer(path, cfg);
+    if (!writer.isOpen()) {
+        return false;
+    }
+
+    MathArchive archive = header();
+    writer.write(Span<const char>((const char *)&archive, sizeof(archive)));
+
+    for (i64 i = 0; i < sections_.size(); i++) {
+        MathArchiveSection section = tableEntry(i);
+        writer.write(
+            Span<const char>((const char *)&section, sizeof(section)));
+    }
+
+    static constexpr char zeros[mathArchiveAlignment] = {};
+
+    i64 data_start = dataStart();
+    for (const PendingSection &pending : sections_) {
+        i64 pad = data_start + pending.dataOffset - writer.size();
+        Span<const char> parts[] = {
+            { zeros, pad },
+            { pending.data, pending.numBytes },
+        };
+        writer.write(Span<const Span<const char>>(parts));
+    }
+
+    return writer.close();
+}
+
+}
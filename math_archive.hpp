@@ -0,0 +1,143 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/math.hpp>
+#include <brt/io.hpp>
+#include <brt/small_vec.hpp>
+
+namespace brt {
+
+// Flat, relocatable container for arrays of math types. The file is the
+// in-memory representation: a buffer holding a whole archive, mapped with
+// MappedFile or read with readBinaryFile at mathArchiveAlignment, is used
+// in place through MathArchive::view with no parse step. Layout:
+//
+//   MathArchive header
+//   MathArchiveSection table
+//   section data, each section aligned to mathArchiveAlignment
+//
+// All pointers inside the archive are RelPtrs, offsets from the pointer's
+// own address, so the buffer can live at any suitably aligned address.
+// Elements are stored exactly as laid out in math.hpp, which is pinned by
+// the static_asserts in math_archive.inl; a layout change must bump
+// mathArchiveVersion. All fields are little endian.
+
+inline constexpr u32 mathArchiveMagic = 0x4854414d; // "MATH"
+inline constexpr u32 mathArchiveVersion = 1;
+inline constexpr i64 mathArchiveAlignment = 64;
+
+// Offset based pointer, valid wherever the bytes holding it and its
+// target are moved together. An offset of 0 is null.
+template <typename T>
+struct RelPtr {
+    i64 offset;
+
+    inline const T * get() const;
+    inline bool isNull() const { return offset == 0; }
+};
+
+template <typename T>
+struct RelSpan {
+    RelPtr<T> data;
+    i64 size;
+
+    inline Span<const T> span() const;
+};
+
+enum class MathArchiveType : u32 {
+    Vector3,
+    Quat,
+    AABB,
+    Mat3x4,
+};
+
+template <typename T>
+inline constexpr MathArchiveType mathArchiveType();
+
+struct MathArchiveSection {
+    // Caller chosen identifier, unique within the archive
+    u32 id;
+    MathArchiveType type;
+    // sizeof the element type when written, checked by view()
+    u32 elemBytes;
+    u32 reserved;
+    RelSpan<char> elems;
+};
+static_assert(sizeof(MathArchiveSection) == 32);
+
+// Root of an archive. Only exists at the start of a buffer validated by
+// view().
+struct MathArchive {
+    u32 magic;
+    u32 version;
+    // mathArchiveLayoutHash() of the writer
+    u32 layoutHash;
+    u32 flags;
+    // Size of the whole archive
+    i64 numBytes;
+    RelSpan<MathArchiveSection> sections;
+    u8 reserved[24];
+
+    // Checks that data, which must be aligned to mathArchiveAlignment,
+    // holds a complete archive written with the same element layouts and
+    // that every section lies inside it. Returns nullptr otherwise.
+    static const MathArchive * view(Span<const char> data);
+
+    inline Span<const MathArchiveSection> sectionTable() const;
+
+    // Elements of section id, or an empty span if the archive has no such
+    // section or it holds a different type
+    template <typename T>
+    inline Span<const T> get(u32 id) const;
+};
+static_assert(sizeof(MathArchive) == 64);
+
+// Hash of the size and field offsets of every element type, stored in the
+// header so builds with a different layout reject the file
+constexpr u32 mathArchiveLayoutHash();
+
+// Collects sections and writes them out as one archive. Sections reference
+// the caller's arrays, which must stay alive until the archive is written.
+class MathArchiveBuilder {
+public:
+    MathArchiveBuilder();
+
+    template <typename T>
+    inline void add(u32 id, Span<const T> elems);
+
+    // Size of the archive
+    i64 numBytes() const;
+
+    // Writes the archive to dst, which must be aligned to
+    // mathArchiveAlignment and hold numBytes() bytes
+    void serialize(Span<char> dst) const;
+
+    bool write(const char *path, const BinaryWriterConfig &cfg = {}) const;
+
+private:
+    struct PendingSection {
+        u32 id;
+        MathArchiveType type;
+        u32 elemBytes;
+        const char *data;
+        i64 numBytes;
+        // Offset from the start of the section data
+        i64 dataOffset;
+    };
+
+    void addSection(u32 id, MathArchiveType type, u32 elem_bytes,
+                    const void *data, i64 num_elems);
+
+    // Offset of the section data, after the header and section table
+    i64 dataStart() const;
+    MathArchive header() const;
+    MathArchiveSection tableEntry(i64 section_idx) const;
+
+    SmallVec<PendingSection, 8> sections_;
+    i64 data_bytes_;
+};
+
+}
+
+#include "math_archive.inl"
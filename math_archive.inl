@@ -0,0 +1,146 @@
+#include <bit>
+#include <cstddef>
+#include <type_traits>
+
+namespace brt {
+
+// The archive stores elements as their in-memory bytes. These pin the
+// layouts of version 1 of the format; if one fires, math.hpp changed and
+// mathArchiveVersion must be bumped along with the expected values.
+static_assert(std::endian::native == std::endian::little);
+
+static_assert(std::is_trivially_copyable_v<Vector3> &&
+              std::is_standard_layout_v<Vector3>);
+static_assert(sizeof(Vector3) == 12 && alignof(Vector3) == 4);
+static_assert(offsetof(Vector3, x) == 0 && offsetof(Vector3, y) == 4 &&
+              offsetof(Vector3, z) == 8);
+
+static_assert(std::is_trivially_copyable_v<Quat> &&
+              std::is_standard_layout_v<Quat>);
+static_assert(sizeof(Quat) == 16 && alignof(Quat) == 4);
+static_assert(offsetof(Quat, w) == 0 && offsetof(Quat, x) == 4 &&
+              offsetof(Quat, y) == 8 && offsetof(Quat, z) == 12);
+
+static_assert(std::is_trivially_copyable_v<AABB> &&
+              std::is_standard_layout_v<AABB>);
+static_assert(sizeof(AABB) == 24 && alignof(AABB) == 4);
+static_assert(offsetof(AABB, pMin) == 0 && offsetof(AABB, pMax) == 12);
+
+static_assert(std::is_trivially_copyable_v<Mat3x4> &&
+              std::is_standard_layout_v<Mat3x4>);
+static_assert(sizeof(Mat3x4) == 48 && alignof(Mat3x4) == 4);
+static_assert(offsetof(Mat3x4, cols) == 0);
+
+template <typename T>
+const T * RelPtr<T>::get() const
+{
+    if (offset == 0) {
+        return nullptr;
+    }
+
+    return (const T *)((const char *)this + offset);
+}
+
+template <typename T>
+Span<const T> RelSpan<T>::span() const
+{
+    return { data.get(), size };
+}
+
+template <typename T>
+constexpr MathArchiveType mathArchiveType()
+{
+    static_assert(sizeof(T) == 0, "Unsupported MathArchive element type");
+    return MathArchiveType::Vector3;
+}
+
+template <>
+constexpr MathArchiveType mathArchiveType<Vector3>()
+{
+    return MathArchiveType::Vector3;
+}
+
+template <>
+constexpr MathArchiveType mathArchiveType<Quat>()
+{
+    return MathArchiveType::Quat;
+}
+
+template <>
+constexpr MathArchiveType mathArchiveType<AABB>()
+{
+    return MathArchiveType::AABB;
+}
+
+template <>
+constexpr MathArchiveType mathArchiveType<Mat3x4>()
+{
+    return MathArchiveType::Mat3x4;
+}
+
+constexpr u32 mathArchiveLayoutHash()
+{
+    // FNV-1a over the values pinned above
+    u32 hash = 2166136261u;
+    auto mix = [&hash](u64 v) {
+        hash = (hash ^ (u32)v) * 16777619u;
+    };
+
+    mix(sizeof(Vector3));
+    mix(offsetof(Vector3, x));
+    mix(offsetof(Vector3, y));
+    mix(offsetof(Vector3, z));
+
+    mix(sizeof(Quat));
+    mix(offsetof(Quat, w));
+    mix(offsetof(Quat, x));
+    mix(offsetof(Quat, y));
+    mix(offsetof(Quat, z));
+
+    mix(sizeof(AABB));
+    mix(offsetof(AABB, pMin));
+    mix(offsetof(AABB, pMax));
+
+    mix(sizeof(Mat3x4));
+    mix(offsetof(Mat3x4, cols));
+
+    mix(sizeof(MathArchiveSection));
+    mix(sizeof(MathArchive));
+
+    return hash;
+}
+
+Span<const MathArchiveSection> MathArchive::sectionTable() const
+{
+    return sections.span();
+}
+
+template <typename T>
+Span<const T> MathArchive::get(u32 id) const
+{
+    for (const MathArchiveSection &section : sectionTable()) {
+        if (section.id != id) {
+            continue;
+        }
+
+        if (section.type != mathArchiveType<T>()) {
+            return {};
+        }
+
+        return {
+            (const T *)section.elems.data.get(),
+            section.elems.size / (i64)sizeof(T),
+        };
+    }
+
+    return {};
+}
+
+template <typename T>
+void MathArchiveBuilder::add(u32 id, Span<const T> elems)
+{
+    addSection(id, mathArchiveType<T>(), (u32)sizeof(T),
+               elems.data(), elems.size());
+}
+
+}
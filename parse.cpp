@@ -0,0 +1,749 @@
+#include <brt/parse.hpp>
+#include <brt/macros.hpp>
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#if defined(BRT_CXX_MSVC) && !defined(BRT_CXX_CLANG_CL)
+#include <intrin.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+BRT_ALWAYS_INLINE inline bool isDigit(char c)
+{
+    return (u8)(c - '0') < 10;
+}
+
+BRT_ALWAYS_INLINE inline bool isDelimiter(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+BRT_ALWAYS_INLINE inline u64 loadU64(const char *p)
+{
+    u64 v;
+    memcpy(&v, p, sizeof(u64));
+    return v;
+}
+
+// The SWAR helpers below assume a little endian load order, which holds on
+// every platform brt targets. They operate on 8 bytes xor'd with '0', so
+// digit bytes hold their value.
+
+// Returns a mask with the high nibble set in every byte that isn't a digit.
+// A carry out of a non digit byte can only corrupt later bytes, so the
+// lowest set byte is always exact.
+BRT_ALWAYS_INLINE inline u64 nonDigitMask(u64 x)
+{
+    return (x | (x + 0x0606060606060606_u64)) & 0xF0F0F0F0F0F0F0F0_u64;
+}
+
+// Converts 8 digit values, first digit in the lowest byte
+BRT_ALWAYS_INLINE inline u32 parseEightDigits(u64 x)
+{
+    constexpr u64 mask = 0x000000FF000000FF_u64;
+    constexpr u64 mul1 = 0x000F424000000064_u64; // 100 + (1000000 << 32)
+    constexpr u64 mul2 = 0x0000271000000001_u64; // 1 + (10000 << 32)
+
+    x = (x * 10) + (x >> 8);
+    x = (((x & mask) * mul1) + (((x >> 16) & mask) * mul2)) >> 32;
+
+    return (u32)x;
+}
+
+// Accumulates digits into *v, up to 8 at a time while 8 bytes can be
+// loaded. The value wraps if there are more than 19 digits.
+BRT_ALWAYS_INLINE inline const char * accumulateDigits(
+    const char *p, const char *end, u64 *v)
+{
+    constexpr u64 pow10[8] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+    };
+
+    u64 acc = *v;
+    while (end - p >= 8) {
+        u64 x = loadU64(p) ^ 0x3030303030303030_u64;
+        u64 non_digits = nonDigitMask(x);
+        if (non_digits == 0) {
+            acc = acc * 100000000 + parseEightDigits(x);
+            p += 8;
+            continue;
+        }
+
+        // Shift the leading digits to the top so the vacated low bytes
+        // act as leading zeros.
+        i32 num_digits = std::countr_zero(non_digits) >> 3;
+        if (num_digits != 0) {
+            acc = acc * pow10[num_digits] +
+                parseEightDigits(x << (64 - 8 * num_digits));
+            p += num_digits;
+        }
+
+        *v = acc;
+        return p;
+    }
+
+    while (p != end && isDigit(*p)) {
+        acc = acc * 10 + (u64)(*p - '0');
+        p += 1;
+    }
+
+    *v = acc;
+    return p;
+}
+
+BRT_ALWAYS_INLINE inline void mul128(u64 a, u64 b, u64 *lo, u64 *hi)
+{
+#if defined(BRT_CXX_MSVC) && !defined(BRT_CXX_CLANG_CL)
+    *lo = _umul128(a, b, hi);
+#else
+    __extension__ using u128 = unsigned __int128;
+    u128 r = (u128)a * (u128)b;
+    *lo = (u64)r;
+    *hi = (u64)(r >> 64);
+#endif
+}
+
+// Eisel-Lemire conversion of w * 10^q to f32, as described in Daniel
+// Lemire, "Number Parsing at a Gigabyte per Second" (2021), following the
+// fast_float reference implementation.
+namespace lemire {
+
+constexpr i32 mantissa_bits = 23;
+constexpr i32 min_exponent = -127;
+constexpr i32 infinite_power = 0xFF;
+constexpr i32 min_exponent_round_to_even = -17;
+constexpr i32 max_exponent_round_to_even = 10;
+
+// Below this any 19 digit mantissa rounds to 0, above it overflows
+constexpr i32 min_pow10 = -65;
+constexpr i32 max_pow10 = 38;
+
+// 5^q normalized so the top bit is set, truncated to 128 bits (high word
+// first). Negative powers are rounded up.
+constexpr u64 pow5_128[2 * (max_pow10 - min_pow10 + 1)] = {
+    0x86ccbb52ea94baea_u64, 0x98e947129fc2b4e9_u64, // 5^-65
+    0xa87fea27a539e9a5_u64, 0x3f2398d747b36224_u64, // 5^-64
+    0xd29fe4b18e88640e_u64, 0x8eec7f0d19a03aad_u64, // 5^-63
+    0x83a3eeeef9153e89_u64, 0x1953cf68300424ac_u64, // 5^-62
+    0xa48ceaaab75a8e2b_u64, 0x5fa8c3423c052dd7_u64, // 5^-61
+    0xcdb02555653131b6_u64, 0x3792f412cb06794d_u64, // 5^-60
+    0x808e17555f3ebf11_u64, 0xe2bbd88bbee40bd0_u64, // 5^-59
+    0xa0b19d2ab70e6ed6_u64, 0x5b6aceaeae9d0ec4_u64, // 5^-58
+    0xc8de047564d20a8b_u64, 0xf245825a5a445275_u64, // 5^-57
+    0xfb158592be068d2e_u64, 0xeed6e2f0f0d56712_u64, // 5^-56
+    0x9ced737bb6c4183d_u64, 0x55464dd69685606b_u64, // 5^-55
+    0xc428d05aa4751e4c_u64, 0xaa97e14c3c26b886_u64, // 5^-54
+    0xf53304714d9265df_u64, 0xd53dd99f4b3066a8_u64, // 5^-53
+    0x993fe2c6d07b7fab_u64, 0xe546a8038efe4029_u64, // 5^-52
+    0xbf8fdb78849a5f96_u64, 0xde98520472bdd033_u64, // 5^-51
+    0xef73d256a5c0f77c_u64, 0x963e66858f6d4440_u64, // 5^-50
+    0x95a8637627989aad_u64, 0xdde7001379a44aa8_u64, // 5^-49
+    0xbb127c53b17ec159_u64, 0x5560c018580d5d52_u64, // 5^-48
+    0xe9d71b689dde71af_u64, 0xaab8f01e6e10b4a6_u64, // 5^-47
+    0x9226712162ab070d_u64, 0xcab3961304ca70e8_u64, // 5^-46
+    0xb6b00d69bb55c8d1_u64, 0x3d607b97c5fd0d22_u64, // 5^-45
+    0xe45c10c42a2b3b05_u64, 0x8cb89a7db77c506a_u64, // 5^-44
+    0x8eb98a7a9a5b04e3_u64, 0x77f3608e92adb242_u64, // 5^-43
+    0xb267ed1940f1c61c_u64, 0x55f038b237591ed3_u64, // 5^-42
+    0xdf01e85f912e37a3_u64, 0x6b6c46dec52f6688_u64, // 5^-41
+    0x8b61313bbabce2c6_u64, 0x2323ac4b3b3da015_u64, // 5^-40
+    0xae397d8aa96c1b77_u64, 0xabec975e0a0d081a_u64, // 5^-39
+    0xd9c7dced53c72255_u64, 0x96e7bd358c904a21_u64, // 5^-38
+    0x881cea14545c7575_u64, 0x7e50d64177da2e54_u64, // 5^-37
+    0xaa242499697392d2_u64, 0xdde50bd1d5d0b9e9_u64, // 5^-36
+    0xd4ad2dbfc3d07787_u64, 0x955e4ec64b44e864_u64, // 5^-35
+    0x84ec3c97da624ab4_u64, 0xbd5af13bef0b113e_u64, // 5^-34
+    0xa6274bbdd0fadd61_u64, 0xecb1ad8aeacdd58e_u64, // 5^-33
+    0xcfb11ead453994ba_u64, 0x67de18eda5814af2_u64, // 5^-32
+    0x81ceb32c4b43fcf4_u64, 0x80eacf948770ced7_u64, // 5^-31
+    0xa2425ff75e14fc31_u64, 0xa1258379a94d028d_u64, // 5^-30
+    0xcad2f7f5359a3b3e_u64, 0x096ee45813a04330_u64, // 5^-29
+    0xfd87b5f28300ca0d_u64, 0x8bca9d6e188853fc_u64, // 5^-28
+    0x9e74d1b791e07e48_u64, 0x775ea264cf55347e_u64, // 5^-27
+    0xc612062576589dda_u64, 0x95364afe032a819e_u64, // 5^-26
+    0xf79687aed3eec551_u64, 0x3a83ddbd83f52205_u64, // 5^-25
+    0x9abe14cd44753b52_u64, 0xc4926a9672793543_u64, // 5^-24
+    0xc16d9a0095928a27_u64, 0x75b7053c0f178294_u64, // 5^-23
+    0xf1c90080baf72cb1_u64, 0x5324c68b12dd6339_u64, // 5^-22
+    0x971da05074da7bee_u64, 0xd3f6fc16ebca5e04_u64, // 5^-21
+    0xbce5086492111aea_u64, 0x88f4bb1ca6bcf585_u64, // 5^-20
+    0xec1e4a7db69561a5_u64, 0x2b31e9e3d06c32e6_u64, // 5^-19
+    0x9392ee8e921d5d07_u64, 0x3aff322e62439fd0_u64, // 5^-18
+    0xb877aa3236a4b449_u64, 0x09befeb9fad487c3_u64, // 5^-17
+    0xe69594bec44de15b_u64, 0x4c2ebe687989a9b4_u64, // 5^-16
+    0x901d7cf73ab0acd9_u64, 0x0f9d37014bf60a11_u64, // 5^-15
+    0xb424dc35095cd80f_u64, 0x538484c19ef38c95_u64, // 5^-14
+    0xe12e13424bb40e13_u64, 0x2865a5f206b06fba_u64, // 5^-13
+    0x8cbccc096f5088cb_u64, 0xf93f87b7442e45d4_u64, // 5^-12
+    0xafebff0bcb24aafe_u64, 0xf78f69a51539d749_u64, // 5^-11
+    0xdbe6fecebdedd5be_u64, 0xb573440e5a884d1c_u64, // 5^-10
+    0x89705f4136b4a597_u64, 0x31680a88f8953031_u64, // 5^-9
+    0xabcc77118461cefc_u64, 0xfdc20d2b36ba7c3e_u64, // 5^-8
+    0xd6bf94d5e57a42bc_u64, 0x3d32907604691b4d_u64, // 5^-7
+    0x8637bd05af6c69b5_u64, 0xa63f9a49c2c1b110_u64, // 5^-6
+    0xa7c5ac471b478423_u64, 0x0fcf80dc33721d54_u64, // 5^-5
+    0xd1b71758e219652b_u64, 0xd3c36113404ea4a9_u64, // 5^-4
+    0x83126e978d4fdf3b_u64, 0x645a1cac083126ea_u64, // 5^-3
+    0xa3d70a3d70a3d70a_u64, 0x3d70a3d70a3d70a4_u64, // 5^-2
+    0xcccccccccccccccc_u64, 0xcccccccccccccccd_u64, // 5^-1
+    0x8000000000000000_u64, 0x0000000000000000_u64, // 5^0
+    0xa000000000000000_u64, 0x0000000000000000_u64, // 5^1
+    0xc800000000000000_u64, 0x0000000000000000_u64, // 5^2
+    0xfa00000000000000_u64, 0x0000000000000000_u64, // 5^3
+    0x9c40000000000000_u64, 0x0000000000000000_u64, // 5^4
+    0xc350000000000000_u64, 0x0000000000000000_u64, // 5^5
+    0xf424000000000000_u64, 0x0000000000000000_u64, // 5^6
+    0x9896800000000000_u64, 0x0000000000000000_u64, // 5^7
+    0xbebc200000000000_u64, 0x0000000000000000_u64, // 5^8
+    0xee6b280000000000_u64, 0x0000000000000000_u64, // 5^9
+    0x9502f90000000000_u64, 0x0000000000000000_u64, // 5^10
+    0xba43b74000000000_u64, 0x0000000000000000_u64, // 5^11
+    0xe8d4a51000000000_u64, 0x0000000000000000_u64, // 5^12
+    0x9184e72a00000000_u64, 0x0000000000000000_u64, // 5^13
+    0xb5e620f480000000_u64, 0x0000000000000000_u64, // 5^14
+    0xe35fa931a0000000_u64, 0x0000000000000000_u64, // 5^15
+    0x8e1bc9bf04000000_u64, 0x0000000000000000_u64, // 5^16
+    0xb1a2bc2ec5000000_u64, 0x0000000000000000_u64, // 5^17
+    0xde0b6b3a76400000_u64, 0x0000000000000000_u64, // 5^18
+    0x8ac7230489e80000_u64, 0x0000000000000000_u64, // 5^19
+    0xad78ebc5ac620000_u64, 0x0000000000000000_u64, // 5^20
+    0xd8d726b7177a8000_u64, 0x0000000000000000_u64, // 5^21
+    0x878678326eac9000_u64, 0x0000000000000000_u64, // 5^22
+    0xa968163f0a57b400_u64, 0x0000000000000000_u64, // 5^23
+    0xd3c21bcecceda100_u64, 0x0000000000000000_u64, // 5^24
+    0x84595161401484a0_u64, 0x0000000000000000_u64, // 5^25
+    0xa56fa5b99019a5c8_u64, 0x0000000000000000_u64, // 5^26
+    0xcecb8f27f4200f3a_u64, 0x0000000000000000_u64, // 5^27
+    0x813f3978f8940984_u64, 0x4000000000000000_u64, // 5^28
+    0xa18f07d736b90be5_u64, 0x5000000000000000_u64, // 5^29
+    0xc9f2c9cd04674ede_u64, 0xa400000000000000_u64, // 5^30
+    0xfc6f7c4045812296_u64, 0x4d00000000000000_u64, // 5^31
+    0x9dc5ada82b70b59d_u64, 0xf020000000000000_u64, // 5^32
+    0xc5371912364ce305_u64, 0x6c28000000000000_u64, // 5^33
+    0xf684df56c3e01bc6_u64, 0xc732000000000000_u64, // 5^34
+    0x9a130b963a6c115c_u64, 0x3c7f400000000000_u64, // 5^35
+    0xc097ce7bc90715b3_u64, 0x4b9f100000000000_u64, // 5^36
+    0xf0bdc21abb48db20_u64, 0x1e86d40000000000_u64, // 5^37
+    0x96769950b50d88f4_u64, 0x1314448000000000_u64, // 5^38
+};
+
+struct AdjustedMantissa {
+    u64 mantissa;
+    i32 power2;
+
+    bool operator==(const AdjustedMantissa &) const = default;
+};
+
+// floor(log2(10^q)) + 63
+inline i32 power(i32 q)
+{
+    return (((152170 + 65536) * q) >> 16) + 63;
+}
+
+AdjustedMantissa computeFloat(i64 q, u64 w)
+{
+    if (w == 0 || q < min_pow10) {
+        return { 0, 0 };
+    }
+
+    if (q > max_pow10) {
+        return { 0, infinite_power };
+    }
+
+    i32 lz = std::countl_zero(w);
+    w <<= lz;
+
+    // 128 bit approximation of w * 5^q. Only mantissa_bits + 3 bits of the
+    // high word matter; the second multiplication is needed only when the
+    // bits below them are all ones and a carry could reach them.
+    const i64 idx = 2 * (q - min_pow10);
+    u64 lo, hi;
+    mul128(w, pow5_128[idx], &lo, &hi);
+
+    constexpr u64 precision_mask = ~0_u64 >> (mantissa_bits + 3);
+    if ((hi & precision_mask) == precision_mask) {
+        u64 lo2, hi2;
+        mul128(w, pow5_128[idx + 1], &lo2, &hi2);
+        lo += hi2;
+        if (hi2 > lo) {
+            hi += 1;
+        }
+    }
+
+    const i32 upper_bit = (i32)(hi >> 63);
+    const i32 shift = upper_bit + 64 - mantissa_bits - 3;
+
+    AdjustedMantissa am;
+    am.mantissa = hi >> shift;
+    am.power2 = power((i32)q) + upper_bit - lz - min_exponent;
+
+    if (am.power2 <= 0) {
+        // Subnormal
+        if (-am.power2 + 1 >= 64) {
+            return { 0, 0 };
+        }
+
+        am.mantissa >>= -am.power2 + 1;
+        am.mantissa += am.mantissa & 1;
+        am.mantissa >>= 1;
+        am.power2 = am.mantissa < (1_u64 << mantissa_bits) ? 0 : 1;
+        return am;
+    }
+
+    // Exactly halfway between two floats: round to even. Only possible
+    // for small q, where 5^q is represented exactly.
+    if (lo <= 1 && q >= min_exponent_round_to_even &&
+            q <= max_exponent_round_to_even && (am.mantissa & 3) == 1 &&
+            (am.mantissa << shift) == hi) {
+        am.mantissa &= ~1_u64;
+    }
+
+    am.mantissa += am.mantissa & 1;
+    am.mantissa >>= 1;
+    if (am.mantissa >= (2_u64 << mantissa_bits)) {
+        am.mantissa = 1_u64 << mantissa_bits;
+        am.power2 += 1;
+    }
+
+    am.mantissa &= ~(1_u64 << mantissa_bits);
+    if (am.power2 >= infinite_power) {
+        return { 0, infinite_power };
+    }
+
+    return am;
+}
+
+inline f32 toF32(AdjustedMantissa am, bool negative)
+{
+    u32 bits = (u32)am.mantissa | ((u32)am.power2 << mantissa_bits) |
+        ((u32)negative << 31);
+    return std::bit_cast<f32>(bits);
+}
+
+}
+
+struct DecimalNumber {
+    u64 mantissa;
+    i64 exponent;
+    bool negative;
+    // More than 19 significant digits; mantissa holds the first 19
+    bool truncated;
+};
+
+i64 parseSpecial(const char *p, const char *end, bool negative, f32 *out)
+{
+    auto matches = [&](const char *word, i64 len) {
+        if (end - p < len) {
+            return false;
+        }
+
+        for (i64 i = 0; i < len; i++) {
+            if ((p[i] | 0x20) != word[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    if (matches("nan", 3)) {
+        f32 nan = std::numeric_limits<f32>::quiet_NaN();
+        *out = negative ? -nan : nan;
+        return 3;
+    }
+
+    if (matches("infinity", 8)) {
+        *out = negative ? -std::numeric_limits<f32>::infinity() :
+            std::numeric_limits<f32>::infinity();
+        return 8;
+    }
+
+    if (matches("inf", 3)) {
+        *out = negative ? -std::numeric_limits<f32>::infinity() :
+            std::numeric_limits<f32>::infinity();
+        return 3;
+    }
+
+    return 0;
+}
+
+// Returns the end of the number or nullptr if there are no digits
+const char * parseDecimal(const char *p, const char *end, DecimalNumber *out)
+{
+    out->negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        out->negative = *p == '-';
+        p += 1;
+    }
+
+    u64 w = 0;
+    const char *int_start = p;
+    p = accumulateDigits(p, end, &w);
+    const char *int_end = p;
+
+    const char *frac_start = p;
+    const char *frac_end = p;
+    if (p != end && *p == '.') {
+        frac_start = p + 1;
+        p = accumulateDigits(frac_start, end, &w);
+        frac_end = p;
+    }
+
+    i64 num_digits = (int_end - int_start) + (frac_end - frac_start);
+    if (num_digits == 0) {
+        return nullptr;
+    }
+
+    i64 explicit_exponent = 0;
+    if (p != end && (*p | 0x20) == 'e') {
+        const char *exp_p = p + 1;
+        bool exp_negative = false;
+        if (exp_p != end && (*exp_p == '-' || *exp_p == '+')) {
+            exp_negative = *exp_p == '-';
+            exp_p += 1;
+        }
+
+        // An 'e' without digits isn't part of the number
+        if (exp_p != end && isDigit(*exp_p)) {
+            i64 e = 0;
+            while (exp_p != end && isDigit(*exp_p)) {
+                if (e < 0x10000) {
+                    e = e * 10 + (*exp_p - '0');
+                }
+                exp_p += 1;
+            }
+
+            explicit_exponent = exp_negative ? -e : e;
+            p = exp_p;
+        }
+    }
+
+    out->mantissa = w;
+    out->exponent = explicit_exponent - (frac_end - frac_start);
+    out->truncated = false;
+
+    if (num_digits > 19) [[unlikely]] {
+        // Leading zeros don't count towards the 19 digits
+        const char *sig = int_start;
+        while (sig != frac_end && (*sig == '0' || *sig == '.')) {
+            if (*sig == '0') {
+                num_digits -= 1;
+            }
+            sig += 1;
+        }
+
+        if (num_digits > 19) {
+            constexpr u64 min_19_digit = 1000000000000000000_u64;
+
+            out->truncated = true;
+            w = 0;
+            const char *d = int_start;
+            while (w < min_19_digit && d != int_end) {
+                w = w * 10 + (u64)(*d - '0');
+                d += 1;
+            }
+
+            if (w >= min_19_digit) {
+                out->exponent = explicit_exponent + (int_end - d);
+            } else {
+                d = frac_start;
+                while (w < min_19_digit && d != frac_end) {
+                    w = w * 10 + (u64)(*d - '0');
+                    d += 1;
+                }
+                out->exponent = explicit_exponent - (d - frac_start);
+            }
+
+            out->mantissa = w;
+        }
+    }
+
+    return p;
+}
+
+f32 strtofFallback(const char *start, const char *end)
+{
+    i64 len = end - start;
+
+    char stack_buf[1024];
+    char *buf = len < (i64)sizeof(stack_buf) ?
+        stack_buf : (char *)malloc(len + 1);
+
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    f32 v = strtof(buf, nullptr);
+
+    if (buf != stack_buf) {
+        free(buf);
+    }
+
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline i64 parseF32Impl(const char *start, const char *end,
+                                          f32 *out)
+{
+    DecimalNumber dec;
+    const char *p = parseDecimal(start, end, &dec);
+    if (p == nullptr) [[unlikely]] {
+        const char *s = start;
+        bool negative = false;
+        if (s != end && (*s == '-' || *s == '+')) {
+            negative = *s == '-';
+            s += 1;
+        }
+
+        i64 num_bytes = parseSpecial(s, end, negative, out);
+        return num_bytes == 0 ? 0 : num_bytes + (s - start);
+    }
+
+    using namespace lemire;
+
+    // There's deliberately no exact float fast path (Clinger): on mixed
+    // input the branch between the two paths mispredicts often enough to
+    // cost more than the multiplication it saves.
+    AdjustedMantissa am = computeFloat(dec.exponent, dec.mantissa);
+    if (dec.truncated) [[unlikely]] {
+        // The dropped digits lie between mantissa and mantissa + 1
+        if (!(am == computeFloat(dec.exponent, dec.mantissa + 1))) {
+            *out = strtofFallback(start, p);
+            return p - start;
+        }
+    }
+
+    *out = toF32(am, dec.negative);
+    return p - start;
+}
+
+// Returns a bitmask with bit i set if block[i] is a delimiter
+BRT_ALWAYS_INLINE inline u64 delimiterMask64(const char *block)
+{
+#if defined(__AVX2__)
+    auto mask32 = [](const char *p) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i d = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                            _mm256_or_si256(
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')))));
+        return (u64)(u32)_mm256_movemask_epi8(d);
+    };
+
+    return mask32(block) | (mask32(block + 32) << 32);
+#elif defined(__SSE2__)
+    auto mask16 = [](const char *p) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i d = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                                      _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')))));
+        return (u64)(u32)_mm_movemask_epi8(d);
+    };
+
+    return mask16(block) | (mask16(block + 16) << 16) |
+        (mask16(block + 32) << 32) | (mask16(block + 48) << 48);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t bit_weights = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    };
+
+    auto weighted16 = [&](const char *p) {
+        uint8x16_t v = vld1q_u8((const u8 *)p);
+        uint8x16_t d = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                     vceqq_u8(v, vdupq_n_u8(','))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')),
+                     vorrq_u8(vceqq_u8(v, vdupq_n_u8('\t')),
+                              vceqq_u8(v, vdupq_n_u8('\r')))));
+        return vandq_u8(d, bit_weights);
+    };
+
+    uint8x16_t s0 = vpaddq_u8(weighted16(block), weighted16(block + 16));
+    uint8x16_t s1 = vpaddq_u8(weighted16(block + 32), weighted16(block + 48));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+#else
+    u64 mask = 0;
+    for (i32 i = 0; i < 64; i++) {
+        mask |= (u64)isDelimiter(block[i]) << i;
+    }
+    return mask;
+#endif
+}
+
+}
+
+i64 parseU64(Span<const char> str, u64 *out)
+{
+    const char *p = str.data();
+    const char *end = p + str.size();
+
+    const char *start = p;
+    while (p != end && *p == '0') {
+        p += 1;
+    }
+    const char *sig_start = p;
+
+    u64 v = 0;
+    p = accumulateDigits(p, end, &v);
+
+    i64 num_sig_digits = p - sig_start;
+    if (p == start) {
+        return 0;
+    }
+
+    if (num_sig_digits > 20) {
+        return 0;
+    }
+
+    // The first 19 digits always fit, so redo the last step with an exact
+    // overflow check
+    if (num_sig_digits == 20) {
+        constexpr u64 max = std::numeric_limits<u64>::max();
+
+        u64 head = 0;
+        accumulateDigits(sig_start, sig_start + 19, &head);
+        u64 last = (u64)(sig_start[19] - '0');
+
+        if (head > max / 10 || (head == max / 10 && last > max % 10)) {
+            return 0;
+        }
+    }
+
+    *out = v;
+    return p - start;
+}
+
+i64 parseU32(Span<const char> str, u32 *out)
+{
+    u64 v;
+    i64 num_bytes = parseU64(str, &v);
+    if (num_bytes == 0 || v > 0xFFFF'FFFF_u64) {
+        return 0;
+    }
+
+    *out = (u32)v;
+    return num_bytes;
+}
+
+i64 parseI64(Span<const char> str, i64 *out)
+{
+    if (str.size() == 0) {
+        return 0;
+    }
+
+    bool negative = str[0] == '-';
+    i64 sign_bytes = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+
+    u64 v;
+    i64 num_bytes = parseU64(
+        Span<const char>(str.data() + sign_bytes, str.size() - sign_bytes),
+        &v);
+    if (num_bytes == 0) {
+        return 0;
+    }
+
+    u64 limit = negative ? (1_u64 << 63) : (1_u64 << 63) - 1;
+    if (v > limit) {
+        return 0;
+    }
+
+    *out = negative ? (i64)(0_u64 - v) : (i64)v;
+    return num_bytes + sign_bytes;
+}
+
+i64 parseI32(Span<const char> str, i32 *out)
+{
+    i64 v;
+    i64 num_bytes = parseI64(str, &v);
+    if (num_bytes == 0 || v < INT32_MIN || v > INT32_MAX) {
+        return 0;
+    }
+
+    *out = (i32)v;
+    return num_bytes;
+}
+
+i64 parseF32(Span<const char> str, f32 *out)
+{
+    return parseF32Impl(str.data(), str.data() + str.size(), out);
+}
+
+i64 parseF32Batch(Span<const char> str, Span<f32> out, i64 *out_num_bytes)
+{
+    const char *base = str.data();
+    const char *end = base + str.size();
+    const i64 num_bytes = str.size();
+
+    i64 num_parsed = 0;
+    i64 parsed_end = 0;
+    // Whether the byte before the current block is part of a token
+    u64 prev_in_token = 0;
+
+    auto finish = [&]() {
+        if (out_num_bytes != nullptr) {
+            *out_num_bytes = parsed_end;
+        }
+
+        return num_parsed;
+    };
+
+    for (i64 block_start = 0; block_start < num_bytes; block_start += 64) {
+        u64 delims;
+        if (num_bytes - block_start >= 64) {
+            delims = delimiterMask64(base + block_start);
+        } else {
+            // Pad the tail with delimiters
+            char tail[64];
+            i64 tail_len = num_bytes - block_start;
+            memcpy(tail, base + block_start, tail_len);
+            memset(tail + tail_len, ' ', 64 - tail_len);
+            delims = delimiterMask64(tail);
+        }
+
+        u64 in_token = ~delims;
+        u64 token_starts = in_token & ~((in_token << 1) | prev_in_token);
+        prev_in_token = in_token >> 63;
+
+        while (token_starts != 0) {
+            i64 pos = block_start + std::countr_zero(token_starts);
+            token_starts &= token_starts - 1;
+
+            if (num_parsed == out.size()) {
+                return finish();
+            }
+
+            f32 v;
+            i64 len = parseF32Impl(base + pos, end, &v);
+            const char *token_end = base + pos + len;
+            if (len == 0 || (token_end != end && !isDelimiter(*token_end))) {
+                return finish();
+            }
+
+            out[num_parsed++] = v;
+            parsed_end = pos + len;
+        }
+    }
+
+    return finish();
+}
+
+}
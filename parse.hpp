@@ -0,0 +1,35 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// Parse a number from the start of str and return the number of bytes
+// consumed, or 0 if str doesn't start with a valid number or the value
+// doesn't fit in the output type. Leading whitespace is not skipped.
+// *out is only written on success.
+//
+// Integers are plain decimal digits; the signed variants accept a
+// leading '-' or '+'.
+i64 parseU32(Span<const char> str, u32 *out);
+i64 parseU64(Span<const char> str, u64 *out);
+i64 parseI32(Span<const char> str, i32 *out);
+i64 parseI64(Span<const char> str, i64 *out);
+
+// Accepts the strtof decimal syntax ("-1.5", ".5", "2.", "1e-3"), plus
+// "inf", "infinity" and "nan" in any case. Rounds to nearest even like
+// strtof; out of range values become 0 or infinity. Uses the
+// Eisel-Lemire algorithm and falls back to strtof only when more than 19
+// significant digits leave the result ambiguous.
+i64 parseF32(Span<const char> str, f32 *out);
+
+// Parses floats separated by runs of spaces, tabs, newlines or commas
+// into out. Stops when out is full, at the end of str, or at the first
+// token that isn't a complete float. Returns the number of floats
+// written; if out_num_bytes is provided it receives the offset just past
+// the last parsed float.
+i64 parseF32Batch(Span<const char> str, Span<f32> out,
+                  i64 *out_num_bytes = nullptr);
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/stack_alloc.hpp>
+#include <brt/utils.hpp>
+
+namespace brt {
+
+// LSD radix sorts with 11 bit digits. Supported key types are u32, i32,
+// u64, i64 and f32 (floats are bit flipped so negative values and -0.0
+// order correctly; NaNs sort to the ends by sign). All sorts are stable.
+//
+// Ping-pong scratch buffers are allocated from alloc and released before
+// returning. Passes whose digit is identical for every key are skipped.
+// If parallel_for is provided, large inputs are split into tasks that
+// build per task histograms and scatter their chunk independently.
+
+template <typename K>
+void radixSort(Span<K> keys, StackAlloc &alloc,
+               const ParallelFor *parallel_for = nullptr);
+
+// Sorts keys and applies the same permutation to values, which must be
+// the same size as keys.
+template <typename K, typename V>
+void radixSortPairs(Span<K> keys, Span<V> values, StackAlloc &alloc,
+                    const ParallelFor *parallel_for = nullptr);
+
+// Writes the sorted order of keys to out_indices without modifying keys:
+// keys[out_indices[0]] <= keys[out_indices[1]] <= ...
+// out_indices must be the same size as keys.
+template <typename K>
+void radixSortIndices(Span<const K> keys, Span<u32> out_indices,
+                      StackAlloc &alloc,
+                      const ParallelFor *parallel_for = nullptr);
+
+}
+
+#include "radix_sort.inl"
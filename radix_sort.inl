@@ -0,0 +1,320 @@
+#include <brt/err.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+namespace brt {
+
+template <typename K>
+struct RadixKey;
+
+template <>
+struct RadixKey<u32> {
+    using Bits = u32;
+    static constexpr bool identity = true;
+    static inline u32 encode(u32 k) { return k; }
+    static inline u32 decode(u32 b) { return b; }
+};
+
+template <>
+struct RadixKey<u64> {
+    using Bits = u64;
+    static constexpr bool identity = true;
+    static inline u64 encode(u64 k) { return k; }
+    static inline u64 decode(u64 b) { return b; }
+};
+
+template <>
+struct RadixKey<i32> {
+    using Bits = u32;
+    static constexpr bool identity = false;
+    static inline u32 encode(i32 k) { return (u32)k ^ 0x8000'0000_u32; }
+    static inline i32 decode(u32 b) { return (i32)(b ^ 0x8000'0000_u32); }
+};
+
+template <>
+struct RadixKey<i64> {
+    using Bits = u64;
+    static constexpr bool identity = false;
+    static inline u64 encode(i64 k)
+    {
+        return (u64)k ^ 0x8000'0000'0000'0000_u64;
+    }
+
+    static inline i64 decode(u64 b)
+    {
+        return (i64)(b ^ 0x8000'0000'0000'0000_u64);
+    }
+};
+
+// Negative floats have all bits flipped, positive floats only the sign bit
+template <>
+struct RadixKey<f32> {
+    using Bits = u32;
+    static constexpr bool identity = false;
+
+    static inline u32 encode(f32 k)
+    {
+        u32 b = std::bit_cast<u32>(k);
+        u32 mask = (0_u32 - (b >> 31)) | 0x8000'0000_u32;
+        return b ^ mask;
+    }
+
+    static inline f32 decode(u32 b)
+    {
+        u32 mask = ((b >> 31) - 1) | 0x8000'0000_u32;
+        return std::bit_cast<f32>(b ^ mask);
+    }
+};
+
+namespace radix {
+
+inline constexpr i32 digitBits = 11;
+inline constexpr u32 numBuckets = 1_u32 << digitBits;
+inline constexpr i64 minElemsPerTask = 65536;
+inline constexpr i64 maxTasks = 64;
+inline constexpr i64 minElemsForRadix = 256;
+
+template <typename Bits>
+BRT_ALWAYS_INLINE inline u32 digit(Bits b, i32 pass)
+{
+    return (u32)(b >> (pass * digitBits)) & (numBuckets - 1);
+}
+
+inline i64 numTasks(i64 num_elems, const ParallelFor *parallel_for)
+{
+    if (parallel_for == nullptr || num_elems < 2 * minElemsPerTask) {
+        return 1;
+    }
+
+    i64 num_tasks = num_elems / minElemsPerTask;
+    return num_tasks < maxTasks ? num_tasks : maxTasks;
+}
+
+// Calls fn(task_idx, start, end) over num_tasks even chunks of num_elems
+template <typename Fn>
+inline void forChunks(const ParallelFor *parallel_for, i64 num_tasks,
+                      i64 num_elems, const Fn &fn)
+{
+    auto runTask = [&](i64 task_idx) {
+        i64 start = num_elems * task_idx / num_tasks;
+        i64 end = num_elems * (task_idx + 1) / num_tasks;
+        fn(task_idx, start, end);
+    };
+
+    if (num_tasks == 1) {
+        runTask(0);
+    } else {
+        runParallel(*parallel_for, num_tasks, runTask);
+    }
+}
+
+// keys_writable: keys may be used as the first ping-pong buffer
+// gen_indices: values are ignored on input and receive the sorted order
+template <typename K, typename V, bool has_values, bool gen_indices>
+void sortImpl(K *keys, bool keys_writable, V *values, i64 num_elems,
+              StackAlloc &alloc, const ParallelFor *parallel_for)
+{
+    using Traits = RadixKey<K>;
+    using Bits = typename Traits::Bits;
+    constexpr i32 num_passes = (i32)divideRoundUp<u64>(
+        sizeof(Bits) * 8, (u64)digitBits);
+
+    if (num_elems <= 1) {
+        if constexpr (gen_indices) {
+            if (num_elems == 1) {
+                values[0] = 0;
+            }
+        }
+        return;
+    }
+
+    AllocFrame frame = alloc.push();
+
+    Bits *key_bufs[2];
+    if constexpr (Traits::identity) {
+        key_bufs[0] = keys_writable ? keys : alloc.allocN<Bits>(num_elems);
+    } else {
+        key_bufs[0] = alloc.allocN<Bits>(num_elems);
+    }
+    key_bufs[1] = alloc.allocN<Bits>(num_elems);
+
+    V *value_bufs[2] = { nullptr, nullptr };
+    if constexpr (has_values) {
+        value_bufs[0] = values;
+        value_bufs[1] = alloc.allocN<V>(num_elems);
+    }
+
+    const i64 num_tasks = numTasks(num_elems, parallel_for);
+
+    // Per task histograms for every pass, built while encoding the keys.
+    u32 *task_hists = alloc.allocN<u32>(
+        num_tasks * num_passes * numBuckets);
+    zeroN<u32>(task_hists, num_tasks * num_passes * numBuckets);
+
+    forChunks(parallel_for, num_tasks, num_elems,
+              [&](i64 task_idx, i64 start, i64 end) {
+        u32 *hist = task_hists + task_idx * num_passes * numBuckets;
+        Bits *dst = key_bufs[0];
+
+        for (i64 i = start; i < end; i++) {
+            Bits b = Traits::encode(keys[i]);
+            if (dst != (Bits *)keys) {
+                dst[i] = b;
+            }
+
+BRT_UNROLL
+            for (i32 pass = 0; pass < num_passes; pass++) {
+                hist[pass * numBuckets + digit(b, pass)] += 1;
+            }
+        }
+    });
+
+    u32 *hists = task_hists;
+    for (i64 t = 1; t < num_tasks; t++) {
+        const u32 *task_hist = task_hists + t * num_passes * numBuckets;
+        for (i64 i = 0; i < num_passes * numBuckets; i++) {
+            hists[i] += task_hist[i];
+        }
+    }
+
+    // Per task scatter offsets for the current pass
+    u32 *offsets = alloc.allocN<u32>(num_tasks * numBuckets);
+    u32 *pass_hist = num_tasks > 1 ?
+        alloc.allocN<u32>(num_tasks * numBuckets) : nullptr;
+
+    i32 cur = 0;
+    bool values_generated = false;
+    for (i32 pass = 0; pass < num_passes; pass++) {
+        const u32 *hist = hists + pass * numBuckets;
+        const Bits *src = key_bufs[cur];
+        Bits *dst = key_bufs[cur ^ 1];
+        const V *src_values = value_bufs[cur];
+        V *dst_values = value_bufs[cur ^ 1];
+
+        if (hist[digit(src[0], pass)] == (u32)num_elems) {
+            continue;
+        }
+
+        if (num_tasks == 1) {
+            u32 sum = 0;
+            for (u32 d = 0; d < numBuckets; d++) {
+                offsets[d] = sum;
+                sum += hist[d];
+            }
+        } else {
+            // Chunk contents change every pass, so the per task
+            // histograms for this digit are rebuilt.
+            zeroN<u32>(pass_hist, num_tasks * numBuckets);
+            forChunks(parallel_for, num_tasks, num_elems,
+                      [&](i64 task_idx, i64 start, i64 end) {
+                u32 *task_hist = pass_hist + task_idx * numBuckets;
+                for (i64 i = start; i < end; i++) {
+                    task_hist[digit(src[i], pass)] += 1;
+                }
+            });
+
+            u32 sum = 0;
+            for (u32 d = 0; d < numBuckets; d++) {
+                for (i64 t = 0; t < num_tasks; t++) {
+                    offsets[t * numBuckets + d] = sum;
+                    sum += pass_hist[t * numBuckets + d];
+                }
+            }
+        }
+
+        const bool first_values_pass = !values_generated;
+        forChunks(parallel_for, num_tasks, num_elems,
+                  [&](i64 task_idx, i64 start, i64 end) {
+            u32 *task_offsets = offsets + task_idx * numBuckets;
+
+            for (i64 i = start; i < end; i++) {
+                Bits b = src[i];
+                u32 pos = task_offsets[digit(b, pass)]++;
+                dst[pos] = b;
+
+                if constexpr (gen_indices) {
+                    dst_values[pos] =
+                        first_values_pass ? (V)i : src_values[i];
+                } else if constexpr (has_values) {
+                    dst_values[pos] = src_values[i];
+                }
+            }
+        });
+
+        values_generated = true;
+        cur ^= 1;
+    }
+
+    const Bits *sorted_keys = key_bufs[cur];
+    forChunks(parallel_for, num_tasks, num_elems,
+              [&](i64, i64 start, i64 end) {
+        if (keys_writable && (Bits *)keys != sorted_keys) {
+            for (i64 i = start; i < end; i++) {
+                keys[i] = Traits::decode(sorted_keys[i]);
+            }
+        }
+
+        if constexpr (gen_indices) {
+            if (!values_generated) {
+                for (i64 i = start; i < end; i++) {
+                    values[i] = (V)i;
+                }
+                return;
+            }
+        }
+
+        if constexpr (has_values) {
+            if (cur == 1) {
+                copyN<V>(values + start, value_bufs[1] + start, end - start);
+            }
+        }
+    });
+
+    alloc.pop(frame);
+}
+
+}
+
+template <typename K>
+void radixSort(Span<K> keys, StackAlloc &alloc,
+               const ParallelFor *parallel_for)
+{
+    // Clearing and scanning the histograms dominates for short arrays.
+    // Stability doesn't matter here since equal keys are identical.
+    if (keys.size() < radix::minElemsForRadix) {
+        std::sort(keys.begin(), keys.end(), [](K a, K b) {
+            return RadixKey<K>::encode(a) < RadixKey<K>::encode(b);
+        });
+        return;
+    }
+
+    radix::sortImpl<K, u32, false, false>(
+        keys.data(), true, nullptr, keys.size(), alloc, parallel_for);
+}
+
+template <typename K, typename V>
+void radixSortPairs(Span<K> keys, Span<V> values, StackAlloc &alloc,
+                    const ParallelFor *parallel_for)
+{
+    static_assert(std::is_trivially_copyable_v<V>);
+    chk(values.size() == keys.size());
+
+    radix::sortImpl<K, V, true, false>(
+        keys.data(), true, values.data(), keys.size(), alloc, parallel_for);
+}
+
+template <typename K>
+void radixSortIndices(Span<const K> keys, Span<u32> out_indices,
+                      StackAlloc &alloc, const ParallelFor *parallel_for)
+{
+    chk(out_indices.size() == keys.size());
+
+    radix::sortImpl<K, u32, true, true>(
+        const_cast<K *>(keys.data()), false, out_indices.data(),
+        keys.size(), alloc, parallel_for);
+}
+
+}
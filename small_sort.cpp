@@ -0,0 +1,277 @@
+#include <brt/small_sort.hpp>
+#include <brt/err.hpp>
+#include <brt/utils.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+inline void checkBitonicSize(i64 num_elems)
+{
+    chk(num_elems >= minBitonicSortElems &&
+        num_elems <= maxBitonicSortElems && isPower2((u64)num_elems));
+}
+
+#if defined(__AVX2__)
+
+template <typename T>
+struct AVXOps;
+
+// min(b, a) / max(a, b) pick a and b consistently even for NaNs, so a
+// compare-exchange always permutes its inputs
+template <>
+struct AVXOps<f32> {
+    static BRT_ALWAYS_INLINE inline __m256i min(__m256i a, __m256i b)
+    {
+        return _mm256_castps_si256(_mm256_min_ps(
+            _mm256_castsi256_ps(b), _mm256_castsi256_ps(a)));
+    }
+
+    static BRT_ALWAYS_INLINE inline __m256i max(__m256i a, __m256i b)
+    {
+        return _mm256_castps_si256(_mm256_max_ps(
+            _mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+    }
+};
+
+template <>
+struct AVXOps<i32> {
+    static BRT_ALWAYS_INLINE inline __m256i min(__m256i a, __m256i b)
+    {
+        return _mm256_min_epi32(a, b);
+    }
+
+    static BRT_ALWAYS_INLINE inline __m256i max(__m256i a, __m256i b)
+    {
+        return _mm256_max_epi32(a, b);
+    }
+};
+
+template <>
+struct AVXOps<u32> {
+    static BRT_ALWAYS_INLINE inline __m256i min(__m256i a, __m256i b)
+    {
+        return _mm256_min_epu32(a, b);
+    }
+
+    static BRT_ALWAYS_INLINE inline __m256i max(__m256i a, __m256i b)
+    {
+        return _mm256_max_epu32(a, b);
+    }
+};
+
+// Compare-exchange of every lane with lane ^ j. Lanes whose element index
+// has bit j set keep the max, flipped where bit k is set (descending runs)
+template <typename T, i32 j>
+BRT_ALWAYS_INLINE inline __m256i exchangeInRegister(__m256i x, __m256i idx,
+                                                    __m256i k_clear)
+{
+    __m256i p;
+    if constexpr (j == 4) {
+        p = _mm256_permute2x128_si256(x, x, 1);
+    } else if constexpr (j == 2) {
+        p = _mm256_shuffle_epi32(x, 0x4E);
+    } else {
+        p = _mm256_shuffle_epi32(x, 0xB1);
+    }
+
+    __m256i j_clear = _mm256_cmpeq_epi32(
+        _mm256_and_si256(idx, _mm256_set1_epi32(j)), _mm256_setzero_si256());
+    __m256i take_max = _mm256_xor_si256(j_clear, k_clear);
+
+    // x is the low element of the pair in lanes that take the min
+    return _mm256_blendv_epi8(AVXOps<T>::min(x, p), AVXOps<T>::max(p, x),
+                              take_max);
+}
+
+template <typename T>
+void bitonicSortImpl(T *vals, i64 num_elems)
+{
+    constexpr i64 lanes = 8;
+    const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (i64 k = 2; k <= num_elems; k <<= 1) {
+        for (i64 j = k >> 1; j >= lanes; j >>= 1) {
+            for (i64 i = 0; i < num_elems; i += 2 * j) {
+                const bool ascending = (i & k) == 0;
+
+                for (i64 o = i; o < i + j; o += lanes) {
+                    __m256i *pa = (__m256i *)(vals + o);
+                    __m256i *pb = (__m256i *)(vals + o + j);
+                    __m256i a = _mm256_loadu_si256(pa);
+                    __m256i b = _mm256_loadu_si256(pb);
+
+                    __m256i mn = AVXOps<T>::min(a, b);
+                    __m256i mx = AVXOps<T>::max(a, b);
+                    _mm256_storeu_si256(pa, ascending ? mn : mx);
+                    _mm256_storeu_si256(pb, ascending ? mx : mn);
+                }
+            }
+        }
+
+        // Remaining distances 4, 2 and 1 are all applied while the
+        // register is loaded
+        const __m256i k_vec = _mm256_set1_epi32((i32)k);
+        for (i64 o = 0; o < num_elems; o += lanes) {
+            __m256i *p = (__m256i *)(vals + o);
+            __m256i x = _mm256_loadu_si256(p);
+            __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((i32)o), iota);
+            __m256i k_clear = _mm256_cmpeq_epi32(
+                _mm256_and_si256(idx, k_vec), _mm256_setzero_si256());
+
+            if (k > 4) {
+                x = exchangeInRegister<T, 4>(x, idx, k_clear);
+            }
+            if (k > 2) {
+                x = exchangeInRegister<T, 2>(x, idx, k_clear);
+            }
+            x = exchangeInRegister<T, 1>(x, idx, k_clear);
+
+            _mm256_storeu_si256(p, x);
+        }
+    }
+}
+
+#elif defined(__ARM_NEON)
+
+template <typename T>
+struct NEONOps;
+
+template <>
+struct NEONOps<f32> {
+    static BRT_ALWAYS_INLINE inline uint32x4_t lt(uint32x4_t a, uint32x4_t b)
+    {
+        return vcltq_f32(vreinterpretq_f32_u32(a), vreinterpretq_f32_u32(b));
+    }
+};
+
+template <>
+struct NEONOps<i32> {
+    static BRT_ALWAYS_INLINE inline uint32x4_t lt(uint32x4_t a, uint32x4_t b)
+    {
+        return vcltq_s32(vreinterpretq_s32_u32(a), vreinterpretq_s32_u32(b));
+    }
+};
+
+template <>
+struct NEONOps<u32> {
+    static BRT_ALWAYS_INLINE inline uint32x4_t lt(uint32x4_t a, uint32x4_t b)
+    {
+        return vcltq_u32(a, b);
+    }
+};
+
+template <typename T, i32 j>
+BRT_ALWAYS_INLINE inline uint32x4_t exchangeInRegister(uint32x4_t x,
+                                                       uint32x4_t idx,
+                                                       uint32x4_t k_set)
+{
+    uint32x4_t p;
+    if constexpr (j == 2) {
+        p = vextq_u32(x, x, 2);
+    } else {
+        p = vrev64q_u32(x);
+    }
+
+    uint32x4_t j_set = vtstq_u32(idx, vdupq_n_u32(j));
+    uint32x4_t take_max = veorq_u32(j_set, k_set);
+
+    // Swap with the partner if it belongs on this side of the pair
+    uint32x4_t take_p = vbslq_u32(take_max, NEONOps<T>::lt(x, p),
+                                  NEONOps<T>::lt(p, x));
+    return vbslq_u32(take_p, p, x);
+}
+
+template <typename T>
+void bitonicSortImpl(T *vals, i64 num_elems)
+{
+    constexpr i64 lanes = 4;
+    const uint32x4_t iota = { 0, 1, 2, 3 };
+    u32 *words = (u32 *)vals;
+
+    for (i64 k = 2; k <= num_elems; k <<= 1) {
+        for (i64 j = k >> 1; j >= lanes; j >>= 1) {
+            for (i64 i = 0; i < num_elems; i += 2 * j) {
+                const bool ascending = (i & k) == 0;
+
+                for (i64 o = i; o < i + j; o += lanes) {
+                    uint32x4_t a = vld1q_u32(words + o);
+                    uint32x4_t b = vld1q_u32(words + o + j);
+
+                    uint32x4_t swap = NEONOps<T>::lt(b, a);
+                    uint32x4_t mn = vbslq_u32(swap, b, a);
+                    uint32x4_t mx = vbslq_u32(swap, a, b);
+                    vst1q_u32(words + o, ascending ? mn : mx);
+                    vst1q_u32(words + o + j, ascending ? mx : mn);
+                }
+            }
+        }
+
+        const uint32x4_t k_vec = vdupq_n_u32((u32)k);
+        for (i64 o = 0; o < num_elems; o += lanes) {
+            uint32x4_t x = vld1q_u32(words + o);
+            uint32x4_t idx = vaddq_u32(vdupq_n_u32((u32)o), iota);
+            uint32x4_t k_set = vtstq_u32(idx, k_vec);
+
+            if (k > 2) {
+                x = exchangeInRegister<T, 2>(x, idx, k_set);
+            }
+            x = exchangeInRegister<T, 1>(x, idx, k_set);
+
+            vst1q_u32(words + o, x);
+        }
+    }
+}
+
+#else
+
+template <typename T>
+void bitonicSortImpl(T *vals, i64 num_elems)
+{
+    for (i64 k = 2; k <= num_elems; k <<= 1) {
+        for (i64 j = k >> 1; j > 0; j >>= 1) {
+            for (i64 i = 0; i < num_elems; i++) {
+                i64 l = i ^ j;
+                if (l <= i) {
+                    continue;
+                }
+
+                if ((i & k) == 0) {
+                    small_sort::compareExchange(vals[i], vals[l]);
+                } else {
+                    small_sort::compareExchange(vals[l], vals[i]);
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+}
+
+void bitonicSort(f32 *vals, i64 num_elems)
+{
+    checkBitonicSize(num_elems);
+    bitonicSortImpl(vals, num_elems);
+}
+
+void bitonicSort(i32 *vals, i64 num_elems)
+{
+    checkBitonicSize(num_elems);
+    bitonicSortImpl(vals, num_elems);
+}
+
+void bitonicSort(u32 *vals, i64 num_elems)
+{
+    checkBitonicSize(num_elems);
+    bitonicSortImpl(vals, num_elems);
+}
+
+}
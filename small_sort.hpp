@@ -0,0 +1,45 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+
+namespace brt {
+
+// Sorting for short arrays, where std::sort's branches and insertion sort
+// fallback dominate. All kernels sort ascending and are branchless; the
+// relative order of NaNs and of -0.0 / 0.0 is unspecified.
+
+inline constexpr i32 maxSortNetworkElems = 32;
+inline constexpr i64 minBitonicSortElems = 16;
+inline constexpr i64 maxBitonicSortElems = 256;
+
+// Sorts vals[0, N) with Batcher's odd-even merge network (5, 19, 63 and
+// 191 compare-exchanges for N = 4, 8, 16 and 32), fully unrolled into
+// min / max instructions. N must be at most maxSortNetworkElems.
+template <i32 N, typename T>
+inline void sortNetwork(T *vals);
+
+// Sorts keys[0, N) and moves values along with them using conditional
+// moves. Equal keys may be reordered.
+template <i32 N, typename K, typename V>
+inline void sortNetworkPairs(K *keys, V *values);
+
+// SIMD bitonic sorts. num_elems must be a power of two between
+// minBitonicSortElems and maxBitonicSortElems. Compare-exchanges across
+// registers are vertical min / max, those within a register use lane
+// permutes and blends. Builds without AVX2 or NEON use a scalar bitonic
+// network.
+void bitonicSort(f32 *vals, i64 num_elems);
+void bitonicSort(i32 *vals, i64 num_elems);
+void bitonicSort(u32 *vals, i64 num_elems);
+
+// Sorts vals of any length. Arrays up to maxBitonicSortElems long are
+// padded with the largest value of T to the next supported kernel size:
+// a sorting network up to 16 elements, bitonic sort for f32, i32 and u32
+// above that. Longer arrays and other types use std::sort.
+template <typename T>
+inline void smallSort(Span<T> vals);
+
+}
+
+#include "small_sort.inl"
@@ -0,0 +1,192 @@
+#include <brt/macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace brt {
+
+namespace small_sort {
+
+struct Network {
+    static constexpr i32 maxComparators = 191;
+
+    u8 lo[maxComparators];
+    u8 hi[maxComparators];
+    i32 numComparators;
+};
+
+// Batcher's odd-even merge sort for the next power of two above
+// num_elems. Comparators touching padding elements are dropped: padding
+// acts as +inf, so those comparators never swap.
+consteval Network buildNetwork(i32 num_elems)
+{
+    Network net {};
+
+    i32 p2 = 1;
+    while (p2 < num_elems) {
+        p2 <<= 1;
+    }
+
+    for (i32 p = 1; p < p2; p <<= 1) {
+        for (i32 k = p; k >= 1; k >>= 1) {
+            for (i32 j = k % p; j + k < p2; j += 2 * k) {
+                for (i32 i = 0; i < k && i < p2 - j - k; i++) {
+                    i32 a = i + j;
+                    i32 b = i + j + k;
+                    if (a / (2 * p) == b / (2 * p) && b < num_elems) {
+                        net.lo[net.numComparators] = (u8)a;
+                        net.hi[net.numComparators] = (u8)b;
+                        net.numComparators++;
+                    }
+                }
+            }
+        }
+    }
+
+    return net;
+}
+
+template <i32 N>
+inline constexpr Network network = buildNetwork(N);
+
+template <typename T>
+BRT_ALWAYS_INLINE inline void compareExchange(T &a, T &b)
+{
+    T x = a;
+    T y = b;
+    // Matches minss / maxss, so NaNs still leave a permutation of a, b
+    a = x < y ? x : y;
+    b = x < y ? y : x;
+}
+
+template <typename K, typename V>
+BRT_ALWAYS_INLINE inline void compareExchange(K &ka, K &kb, V &va, V &vb)
+{
+    K x = ka;
+    K y = kb;
+    V vx = va;
+    V vy = vb;
+    bool swap = y < x;
+    ka = swap ? y : x;
+    kb = swap ? x : y;
+    va = swap ? vy : vx;
+    vb = swap ? vx : vy;
+}
+
+template <typename T>
+constexpr T largestValue()
+{
+    if constexpr (std::numeric_limits<T>::has_infinity) {
+        return std::numeric_limits<T>::infinity();
+    } else {
+        return std::numeric_limits<T>::max();
+    }
+}
+
+template <i32 N, typename T>
+inline void sortPadded(T *vals, i64 num_elems)
+{
+    T buf[N];
+    for (i64 i = 0; i < num_elems; i++) {
+        buf[i] = vals[i];
+    }
+    for (i64 i = num_elems; i < N; i++) {
+        buf[i] = largestValue<T>();
+    }
+
+    sortNetwork<N>(buf);
+
+    for (i64 i = 0; i < num_elems; i++) {
+        vals[i] = buf[i];
+    }
+}
+
+template <typename T>
+inline void bitonicSortPadded(T *vals, i64 num_elems)
+{
+    alignas(32) T buf[maxBitonicSortElems];
+
+    i64 padded = minBitonicSortElems;
+    while (padded < num_elems) {
+        padded *= 2;
+    }
+
+    for (i64 i = 0; i < num_elems; i++) {
+        buf[i] = vals[i];
+    }
+    for (i64 i = num_elems; i < padded; i++) {
+        buf[i] = largestValue<T>();
+    }
+
+    bitonicSort(buf, padded);
+
+    for (i64 i = 0; i < num_elems; i++) {
+        vals[i] = buf[i];
+    }
+}
+
+}
+
+template <i32 N, typename T>
+void sortNetwork(T *vals)
+{
+    static_assert(N > 0 && N <= maxSortNetworkElems);
+    using small_sort::network;
+
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+        (small_sort::compareExchange(vals[network<N>.lo[Is]],
+                                     vals[network<N>.hi[Is]]), ...);
+    }(std::make_index_sequence<network<N>.numComparators>());
+}
+
+template <i32 N, typename K, typename V>
+void sortNetworkPairs(K *keys, V *values)
+{
+    static_assert(N > 0 && N <= maxSortNetworkElems);
+    using small_sort::network;
+
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+        (small_sort::compareExchange(
+            keys[network<N>.lo[Is]], keys[network<N>.hi[Is]],
+            values[network<N>.lo[Is]], values[network<N>.hi[Is]]), ...);
+    }(std::make_index_sequence<network<N>.numComparators>());
+}
+
+template <typename T>
+void smallSort(Span<T> vals)
+{
+    const i64 num_elems = vals.size();
+    if (num_elems <= 1) {
+        return;
+    }
+
+    constexpr bool has_bitonic = std::is_same_v<T, f32> ||
+        std::is_same_v<T, i32> || std::is_same_v<T, u32>;
+
+    if constexpr (std::is_arithmetic_v<T>) {
+        if (num_elems <= 4) {
+            small_sort::sortPadded<4>(vals.data(), num_elems);
+            return;
+        } else if (num_elems <= 8) {
+            small_sort::sortPadded<8>(vals.data(), num_elems);
+            return;
+        } else if (num_elems <= 16) {
+            small_sort::sortPadded<16>(vals.data(), num_elems);
+            return;
+        }
+
+        if constexpr (has_bitonic) {
+            if (num_elems <= maxBitonicSortElems) {
+                small_sort::bitonicSortPadded(vals.data(), num_elems);
+                return;
+            }
+        }
+    }
+
+    std::sort(vals.begin(), vals.end());
+}
+
+}
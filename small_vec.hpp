@@ -0,0 +1,82 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/stack_alloc.hpp>
+
+#include <type_traits>
+
+namespace brt {
+
+// Growable array that stores up to N elements inline. Once full, elements
+// spill either to the global allocator or, if constructed with one, to a
+// StackAlloc. Arena backed SmallVecs that are the most recent allocation
+// grow in place; memory abandoned on reallocation is reclaimed when the
+// StackAlloc frame is popped, which must not happen while the SmallVec
+// is in use.
+template <typename T, i64 N>
+class SmallVec {
+public:
+    inline SmallVec();
+    inline SmallVec(StackAlloc &alloc);
+    SmallVec(const SmallVec &) = delete;
+    inline SmallVec(SmallVec &&o);
+    inline ~SmallVec();
+
+    SmallVec & operator=(const SmallVec &) = delete;
+    inline SmallVec & operator=(SmallVec &&o);
+
+    template <typename... Args>
+    inline T & emplace(Args &&...args);
+    inline void push(const T &v);
+    inline void push(T &&v);
+    inline void pop();
+
+    inline void clear();
+    inline void reserve(i64 new_capacity);
+    inline void resize(i64 new_size);
+
+    inline T * data() { return data_; }
+    inline const T * data() const { return data_; }
+    inline i64 size() const { return size_; }
+    inline i64 capacity() const { return capacity_; }
+    inline bool isEmpty() const { return size_ == 0; }
+    inline bool isInline() const { return data_ == inlineData(); }
+
+    inline T & operator[](i64 idx) { return data_[idx]; }
+    inline const T & operator[](i64 idx) const { return data_[idx]; }
+
+    inline T * begin() { return data_; }
+    inline T * end() { return data_ + size_; }
+    inline const T * begin() const { return data_; }
+    inline const T * end() const { return data_ + size_; }
+
+private:
+    static_assert(N > 0);
+
+    static constexpr bool trivial_relocate =
+        std::is_trivially_copyable_v<T>;
+
+    inline T * inlineData();
+    inline const T * inlineData() const;
+
+    static inline void relocate(T *dst, T *src, i64 num_elems);
+
+    // Returns storage for at least min_capacity elements, which is data_
+    // if the current allocation grew in place
+    T * allocStorage(i64 min_capacity, i64 *out_capacity);
+    void grow(i64 min_capacity);
+
+    template <typename... Args>
+    T & emplaceGrow(Args &&...args);
+    inline void freeStorage();
+
+    T *data_;
+    i64 size_;
+    i64 capacity_;
+    StackAlloc *alloc_;
+    alignas(T) char inline_[N * sizeof(T)];
+};
+
+}
+
+#include "small_vec.inl"
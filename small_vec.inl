@@ -0,0 +1,243 @@
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace brt {
+
+template <typename T, i64 N>
+SmallVec<T, N>::SmallVec()
+    : data_(inlineData()),
+      size_(0),
+      capacity_(N),
+      alloc_(nullptr)
+{}
+
+template <typename T, i64 N>
+SmallVec<T, N>::SmallVec(StackAlloc &alloc)
+    : data_(inlineData()),
+      size_(0),
+      capacity_(N),
+      alloc_(&alloc)
+{}
+
+template <typename T, i64 N>
+SmallVec<T, N>::SmallVec(SmallVec &&o)
+    : data_(inlineData()),
+      size_(o.size_),
+      capacity_(N),
+      alloc_(o.alloc_)
+{
+    if (o.isInline()) {
+        relocate(data_, o.data_, o.size_);
+    } else {
+        data_ = o.data_;
+        capacity_ = o.capacity_;
+        o.data_ = o.inlineData();
+        o.capacity_ = N;
+    }
+
+    o.size_ = 0;
+}
+
+template <typename T, i64 N>
+SmallVec<T, N>::~SmallVec()
+{
+    clear();
+    freeStorage();
+}
+
+template <typename T, i64 N>
+SmallVec<T, N> & SmallVec<T, N>::operator=(SmallVec &&o)
+{
+    clear();
+    freeStorage();
+
+    data_ = inlineData();
+    size_ = o.size_;
+    capacity_ = N;
+    alloc_ = o.alloc_;
+
+    if (o.isInline()) {
+        relocate(data_, o.data_, o.size_);
+    } else {
+        data_ = o.data_;
+        capacity_ = o.capacity_;
+        o.data_ = o.inlineData();
+        o.capacity_ = N;
+    }
+
+    o.size_ = 0;
+
+    return *this;
+}
+
+template <typename T, i64 N>
+template <typename... Args>
+T & SmallVec<T, N>::emplace(Args &&...args)
+{
+    if (size_ == capacity_) [[unlikely]] {
+        return emplaceGrow(std::forward<Args>(args)...);
+    }
+
+    T *elem = new (data_ + size_) T(std::forward<Args>(args)...);
+    size_ += 1;
+
+    return *elem;
+}
+
+template <typename T, i64 N>
+template <typename... Args>
+T & SmallVec<T, N>::emplaceGrow(Args &&...args)
+{
+    i64 new_capacity;
+    T *new_data = allocStorage(size_ + 1, &new_capacity);
+
+    // args may refer to elements of this vector, so the new element is
+    // constructed before the old storage is relocated and freed
+    T *elem = new (new_data + size_) T(std::forward<Args>(args)...);
+
+    if (new_data != data_) {
+        relocate(new_data, data_, size_);
+        freeStorage();
+        data_ = new_data;
+    }
+
+    capacity_ = new_capacity;
+    size_ += 1;
+
+    return *elem;
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::push(const T &v)
+{
+    emplace(v);
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::push(T &&v)
+{
+    emplace(std::move(v));
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::pop()
+{
+    size_ -= 1;
+    data_[size_].~T();
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::clear()
+{
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (i64 i = 0; i < size_; i++) {
+            data_[i].~T();
+        }
+    }
+
+    size_ = 0;
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::reserve(i64 new_capacity)
+{
+    if (new_capacity > capacity_) {
+        grow(new_capacity);
+    }
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::resize(i64 new_size)
+{
+    if (new_size > capacity_) {
+        grow(new_size);
+    }
+
+    for (i64 i = size_; i < new_size; i++) {
+        new (data_ + i) T();
+    }
+
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (i64 i = new_size; i < size_; i++) {
+            data_[i].~T();
+        }
+    }
+
+    size_ = new_size;
+}
+
+template <typename T, i64 N>
+T * SmallVec<T, N>::inlineData()
+{
+    return (T *)inline_;
+}
+
+template <typename T, i64 N>
+const T * SmallVec<T, N>::inlineData() const
+{
+    return (const T *)inline_;
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::relocate(T *dst, T *src, i64 num_elems)
+{
+    if constexpr (trivial_relocate) {
+        memcpy((void *)dst, (const void *)src, num_elems * sizeof(T));
+    } else {
+        for (i64 i = 0; i < num_elems; i++) {
+            new (dst + i) T(std::move(src[i]));
+            src[i].~T();
+        }
+    }
+}
+
+template <typename T, i64 N>
+T * SmallVec<T, N>::allocStorage(i64 min_capacity, i64 *out_capacity)
+{
+    i64 new_capacity = capacity_ * 2;
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
+    }
+    *out_capacity = new_capacity;
+
+    if (alloc_ != nullptr) {
+        if (!isInline() &&
+                alloc_->growInPlace(data_, capacity_ * sizeof(T),
+                                    new_capacity * sizeof(T))) {
+            return data_;
+        }
+
+        return alloc_->allocN<T>(new_capacity);
+    } else {
+        return (T *)operator new(new_capacity * sizeof(T),
+                                 std::align_val_t(alignof(T)));
+    }
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::grow(i64 min_capacity)
+{
+    i64 new_capacity;
+    T *new_data = allocStorage(min_capacity, &new_capacity);
+
+    if (new_data != data_) {
+        relocate(new_data, data_, size_);
+        freeStorage();
+        data_ = new_data;
+    }
+
+    capacity_ = new_capacity;
+}
+
+template <typename T, i64 N>
+void SmallVec<T, N>::freeStorage()
+{
+    if (isInline() || alloc_ != nullptr) {
+        return;
+    }
+
+    operator delete(data_, std::align_val_t(alignof(T)));
+}
+
+}
@@ -0,0 +1,329 @@
+#include <brt/soa.hpp>
+#include <brt/macros.hpp>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace brt {
+
+namespace {
+
+// Each kernel transposes 4 elements at a time and returns the number of
+// elements handled; the scalar loop finishes the remainder.
+
+#if defined(__SSE2__)
+
+#define BRT_SOA_SHUF(a, b, i0, i1, i2, i3) \
+    _mm_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0))
+
+// a = [x0 y0 z0 x1], b = [y1 z1 x2 y2], c = [z2 x3 y3 z3]
+BRT_ALWAYS_INLINE inline void deinterleave3(__m128 a, __m128 b, __m128 c,
+                                            __m128 *x, __m128 *y, __m128 *z)
+{
+    __m128 bc_x = BRT_SOA_SHUF(b, c, 2, 2, 1, 1);
+    *x = BRT_SOA_SHUF(a, bc_x, 0, 3, 0, 2);
+
+    __m128 ab_y = BRT_SOA_SHUF(a, b, 1, 1, 0, 0);
+    __m128 bc_y = BRT_SOA_SHUF(b, c, 3, 3, 2, 2);
+    *y = BRT_SOA_SHUF(ab_y, bc_y, 0, 2, 0, 2);
+
+    __m128 ab_z = BRT_SOA_SHUF(a, b, 2, 2, 1, 1);
+    *z = BRT_SOA_SHUF(ab_z, c, 0, 2, 0, 3);
+}
+
+BRT_ALWAYS_INLINE inline void interleave3(__m128 x, __m128 y, __m128 z,
+                                          __m128 *a, __m128 *b, __m128 *c)
+{
+    *a = BRT_SOA_SHUF(BRT_SOA_SHUF(x, y, 0, 0, 0, 0),
+                      BRT_SOA_SHUF(z, x, 0, 0, 1, 1), 0, 2, 0, 2);
+    *b = BRT_SOA_SHUF(BRT_SOA_SHUF(y, z, 1, 1, 1, 1),
+                      BRT_SOA_SHUF(x, y, 2, 2, 2, 2), 0, 2, 0, 2);
+    *c = BRT_SOA_SHUF(BRT_SOA_SHUF(z, x, 2, 2, 3, 3),
+                      BRT_SOA_SHUF(y, z, 3, 3, 3, 3), 0, 2, 0, 2);
+}
+
+template <i32 num_components>
+i64 deinterleaveSIMD(float * const *dst, const float *src, i64 num_elems)
+{
+    i64 i = 0;
+    for (; i + 4 <= num_elems; i += 4) {
+        const float *s = src + i * num_components;
+
+        if constexpr (num_components == 2) {
+            __m128 a = _mm_loadu_ps(s);
+            __m128 b = _mm_loadu_ps(s + 4);
+            _mm_storeu_ps(dst[0] + i, BRT_SOA_SHUF(a, b, 0, 2, 0, 2));
+            _mm_storeu_ps(dst[1] + i, BRT_SOA_SHUF(a, b, 1, 3, 1, 3));
+        } else if constexpr (num_components == 3) {
+            __m128 x, y, z;
+            deinterleave3(_mm_loadu_ps(s), _mm_loadu_ps(s + 4),
+                          _mm_loadu_ps(s + 8), &x, &y, &z);
+            _mm_storeu_ps(dst[0] + i, x);
+            _mm_storeu_ps(dst[1] + i, y);
+            _mm_storeu_ps(dst[2] + i, z);
+        } else if constexpr (num_components == 4) {
+            __m128 r0 = _mm_loadu_ps(s);
+            __m128 r1 = _mm_loadu_ps(s + 4);
+            __m128 r2 = _mm_loadu_ps(s + 8);
+            __m128 r3 = _mm_loadu_ps(s + 12);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(dst[0] + i, r0);
+            _mm_storeu_ps(dst[1] + i, r1);
+            _mm_storeu_ps(dst[2] + i, r2);
+            _mm_storeu_ps(dst[3] + i, r3);
+        } else if constexpr (num_components == 6) {
+            // Treat each element as two 3 float halves, then split the
+            // even (min) and odd (max) halves apart.
+            __m128 x0, y0, z0, x1, y1, z1;
+            deinterleave3(_mm_loadu_ps(s), _mm_loadu_ps(s + 4),
+                          _mm_loadu_ps(s + 8), &x0, &y0, &z0);
+            deinterleave3(_mm_loadu_ps(s + 12), _mm_loadu_ps(s + 16),
+                          _mm_loadu_ps(s + 20), &x1, &y1, &z1);
+            _mm_storeu_ps(dst[0] + i, BRT_SOA_SHUF(x0, x1, 0, 2, 0, 2));
+            _mm_storeu_ps(dst[1] + i, BRT_SOA_SHUF(y0, y1, 0, 2, 0, 2));
+            _mm_storeu_ps(dst[2] + i, BRT_SOA_SHUF(z0, z1, 0, 2, 0, 2));
+            _mm_storeu_ps(dst[3] + i, BRT_SOA_SHUF(x0, x1, 1, 3, 1, 3));
+            _mm_storeu_ps(dst[4] + i, BRT_SOA_SHUF(y0, y1, 1, 3, 1, 3));
+            _mm_storeu_ps(dst[5] + i, BRT_SOA_SHUF(z0, z1, 1, 3, 1, 3));
+        }
+    }
+
+    return i;
+}
+
+template <i32 num_components>
+i64 interleaveSIMD(float *dst, const float * const *src, i64 num_elems)
+{
+    i64 i = 0;
+    for (; i + 4 <= num_elems; i += 4) {
+        float *d = dst + i * num_components;
+
+        if constexpr (num_components == 2) {
+            __m128 x = _mm_loadu_ps(src[0] + i);
+            __m128 y = _mm_loadu_ps(src[1] + i);
+            _mm_storeu_ps(d, _mm_unpacklo_ps(x, y));
+            _mm_storeu_ps(d + 4, _mm_unpackhi_ps(x, y));
+        } else if constexpr (num_components == 3) {
+            __m128 a, b, c;
+            interleave3(_mm_loadu_ps(src[0] + i), _mm_loadu_ps(src[1] + i),
+                        _mm_loadu_ps(src[2] + i), &a, &b, &c);
+            _mm_storeu_ps(d, a);
+            _mm_storeu_ps(d + 4, b);
+            _mm_storeu_ps(d + 8, c);
+        } else if constexpr (num_components == 4) {
+            __m128 r0 = _mm_loadu_ps(src[0] + i);
+            __m128 r1 = _mm_loadu_ps(src[1] + i);
+            __m128 r2 = _mm_loadu_ps(src[2] + i);
+            __m128 r3 = _mm_loadu_ps(src[3] + i);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(d, r0);
+            _mm_storeu_ps(d + 4, r1);
+            _mm_storeu_ps(d + 8, r2);
+            _mm_storeu_ps(d + 12, r3);
+        } else if constexpr (num_components == 6) {
+            __m128 min_x = _mm_loadu_ps(src[0] + i);
+            __m128 min_y = _mm_loadu_ps(src[1] + i);
+            __m128 min_z = _mm_loadu_ps(src[2] + i);
+            __m128 max_x = _mm_loadu_ps(src[3] + i);
+            __m128 max_y = _mm_loadu_ps(src[4] + i);
+            __m128 max_z = _mm_loadu_ps(src[5] + i);
+
+            __m128 a, b, c;
+            interleave3(_mm_unpacklo_ps(min_x, max_x),
+                        _mm_unpacklo_ps(min_y, max_y),
+                        _mm_unpacklo_ps(min_z, max_z), &a, &b, &c);
+            _mm_storeu_ps(d, a);
+            _mm_storeu_ps(d + 4, b);
+            _mm_storeu_ps(d + 8, c);
+
+            interleave3(_mm_unpackhi_ps(min_x, max_x),
+                        _mm_unpackhi_ps(min_y, max_y),
+                        _mm_unpackhi_ps(min_z, max_z), &a, &b, &c);
+            _mm_storeu_ps(d + 12, a);
+            _mm_storeu_ps(d + 16, b);
+            _mm_storeu_ps(d + 20, c);
+        }
+    }
+
+    return i;
+}
+
+#undef BRT_SOA_SHUF
+
+#elif defined(__ARM_NEON)
+
+template <i32 num_components>
+i64 deinterleaveSIMD(float * const *dst, const float *src, i64 num_elems)
+{
+    i64 i = 0;
+    for (; i + 4 <= num_elems; i += 4) {
+        const float *s = src + i * num_components;
+
+        if constexpr (num_components == 2) {
+            float32x4x2_t v = vld2q_f32(s);
+            vst1q_f32(dst[0] + i, v.val[0]);
+            vst1q_f32(dst[1] + i, v.val[1]);
+        } else if constexpr (num_components == 3) {
+            float32x4x3_t v = vld3q_f32(s);
+            vst1q_f32(dst[0] + i, v.val[0]);
+            vst1q_f32(dst[1] + i, v.val[1]);
+            vst1q_f32(dst[2] + i, v.val[2]);
+        } else if constexpr (num_components == 4) {
+            float32x4x4_t v = vld4q_f32(s);
+            vst1q_f32(dst[0] + i, v.val[0]);
+            vst1q_f32(dst[1] + i, v.val[1]);
+            vst1q_f32(dst[2] + i, v.val[2]);
+            vst1q_f32(dst[3] + i, v.val[3]);
+        } else if constexpr (num_components == 6) {
+            float32x4x3_t lo = vld3q_f32(s);
+            float32x4x3_t hi = vld3q_f32(s + 12);
+            for (i32 c = 0; c < 3; c++) {
+                float32x4x2_t split = vuzpq_f32(lo.val[c], hi.val[c]);
+                vst1q_f32(dst[c] + i, split.val[0]);
+                vst1q_f32(dst[c + 3] + i, split.val[1]);
+            }
+        }
+    }
+
+    return i;
+}
+
+template <i32 num_components>
+i64 interleaveSIMD(float *dst, const float * const *src, i64 num_elems)
+{
+    i64 i = 0;
+    for (; i + 4 <= num_elems; i += 4) {
+        float *d = dst + i * num_components;
+
+        if constexpr (num_components == 2) {
+            float32x4x2_t v;
+            v.val[0] = vld1q_f32(src[0] + i);
+            v.val[1] = vld1q_f32(src[1] + i);
+            vst2q_f32(d, v);
+        } else if constexpr (num_components == 3) {
+            float32x4x3_t v;
+            v.val[0] = vld1q_f32(src[0] + i);
+            v.val[1] = vld1q_f32(src[1] + i);
+            v.val[2] = vld1q_f32(src[2] + i);
+            vst3q_f32(d, v);
+        } else if constexpr (num_components == 4) {
+            float32x4x4_t v;
+            v.val[0] = vld1q_f32(src[0] + i);
+            v.val[1] = vld1q_f32(src[1] + i);
+            v.val[2] = vld1q_f32(src[2] + i);
+            v.val[3] = vld1q_f32(src[3] + i);
+            vst4q_f32(d, v);
+        } else if constexpr (num_components == 6) {
+            float32x4x3_t lo, hi;
+            for (i32 c = 0; c < 3; c++) {
+                float32x4x2_t merged = vzipq_f32(vld1q_f32(src[c] + i),
+                                                 vld1q_f32(src[c + 3] + i));
+                lo.val[c] = merged.val[0];
+                hi.val[c] = merged.val[1];
+            }
+            vst3q_f32(d, lo);
+            vst3q_f32(d + 12, hi);
+        }
+    }
+
+    return i;
+}
+
+#else
+
+template <i32>
+i64 deinterleaveSIMD(float * const *, const float *, i64)
+{
+    return 0;
+}
+
+template <i32>
+i64 interleaveSIMD(float *, const float * const *, i64)
+{
+    return 0;
+}
+
+#endif
+
+template <i32 num_components>
+void deinterleaveImpl(float * const *dst, const float *src, i64 num_elems)
+{
+    i64 i = deinterleaveSIMD<num_components>(dst, src, num_elems);
+
+    for (; i < num_elems; i++) {
+        for (i32 c = 0; c < num_components; c++) {
+            dst[c][i] = src[i * num_components + c];
+        }
+    }
+}
+
+template <i32 num_components>
+void interleaveImpl(float *dst, const float * const *src, i64 num_elems)
+{
+    i64 i = interleaveSIMD<num_components>(dst, src, num_elems);
+
+    for (; i < num_elems; i++) {
+        for (i32 c = 0; c < num_components; c++) {
+            dst[i * num_components + c] = src[c][i];
+        }
+    }
+}
+
+}
+
+void deinterleaveFloats(float * const *dst_components, const float *src,
+                        i32 num_components, i64 num_elems)
+{
+    switch (num_components) {
+        case 2:
+            deinterleaveImpl<2>(dst_components, src, num_elems);
+            break;
+        case 3:
+            deinterleaveImpl<3>(dst_components, src, num_elems);
+            break;
+        case 4:
+            deinterleaveImpl<4>(dst_components, src, num_elems);
+            break;
+        case 6:
+            deinterleaveImpl<6>(dst_components, src, num_elems);
+            break;
+        default:
+            for (i64 i = 0; i < num_elems; i++) {
+                for (i32 c = 0; c < num_components; c++) {
+                    dst_components[c][i] = src[i * num_components + c];
+                }
+            }
+            break;
+    }
+}
+
+void interleaveFloats(float *dst, const float * const *src_components,
+                      i32 num_components, i64 num_elems)
+{
+    switch (num_components) {
+        case 2:
+            interleaveImpl<2>(dst, src_components, num_elems);
+            break;
+        case 3:
+            interleaveImpl<3>(dst, src_components, num_elems);
+            break;
+        case 4:
+            interleaveImpl<4>(dst, src_components, num_elems);
+            break;
+        case 6:
+            interleaveImpl<6>(dst, src_components, num_elems);
+            break;
+        default:
+            for (i64 i = 0; i < num_elems; i++) {
+                for (i32 c = 0; c < num_components; c++) {
+                    dst[i * num_components + c] = src_components[c][i];
+                }
+            }
+            break;
+    }
+}
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <brt/types.hpp>
+#include <brt/span.hpp>
+#include <brt/math.hpp>
+#include <brt/stack_alloc.hpp>
+
+#include <array>
+#include <type_traits>
+
+namespace brt {
+
+// Describes how a struct made up only of floats is split into one array
+// per float. numComponents must equal sizeof(T) / sizeof(float) and
+// Arrays must be a struct of exactly numComponents float pointers, in the
+// same order as the floats appear in T. Specialize for other types to use
+// them with SoAArray.
+template <typename T>
+struct SoATraits;
+
+struct Vector2SoA {
+    float *x;
+    float *y;
+};
+
+struct Vector3SoA {
+    float *x;
+    float *y;
+    float *z;
+};
+
+struct Vector4SoA {
+    float *x;
+    float *y;
+    float *z;
+    float *w;
+};
+
+struct QuatSoA {
+    float *w;
+    float *x;
+    float *y;
+    float *z;
+};
+
+struct AABBSoA {
+    float *minX;
+    float *minY;
+    float *minZ;
+    float *maxX;
+    float *maxY;
+    float *maxZ;
+};
+
+template <>
+struct SoATraits<Vector2> {
+    static constexpr i32 numComponents = 2;
+    using Arrays = Vector2SoA;
+};
+
+template <>
+struct SoATraits<Vector3> {
+    static constexpr i32 numComponents = 3;
+    using Arrays = Vector3SoA;
+};
+
+template <>
+struct SoATraits<Vector4> {
+    static constexpr i32 numComponents = 4;
+    using Arrays = Vector4SoA;
+};
+
+template <>
+struct SoATraits<Quat> {
+    static constexpr i32 numComponents = 4;
+    using Arrays = QuatSoA;
+};
+
+template <>
+struct SoATraits<AABB> {
+    static constexpr i32 numComponents = 6;
+    using Arrays = AABBSoA;
+};
+
+// Reference to element idx of a set of component arrays. Converts to T by
+// gathering the components and scatters them back on assignment.
+template <typename T>
+class SoARef {
+public:
+    static constexpr i32 numComponents = SoATraits<T>::numComponents;
+
+    inline SoARef(float * const *components, i64 idx);
+
+    inline operator T() const;
+    inline T get() const;
+    inline SoARef & operator=(const T &v);
+
+    inline float & component(i32 c) const;
+
+private:
+    float * const *components_;
+    i64 idx_;
+};
+
+// Non owning view of num_elems elements stored as component arrays.
+// Passed by value to kernels; any subrange is also a valid view.
+template <typename T>
+struct SoAView {
+    static constexpr i32 numComponents = SoATraits<T>::numComponents;
+    using Arrays = typename SoATraits<T>::Arrays;
+
+    std::array<float *, numComponents> components;
+    i64 numElems;
+
+    inline i64 size() const { return numElems; }
+    inline float * component(i32 c) const { return components[c]; }
+    inline Arrays arrays() const;
+
+    inline SoARef<T> operator[](i64 idx) const;
+    inline SoAView subview(i64 offset, i64 num_elems) const;
+};
+
+// Fixed size SoA storage for num_elems elements of T. All component arrays
+// live in one allocation, each starting on a 64 byte boundary so full
+// SIMD registers can be loaded from any component at aligned offsets.
+// Elements are left uninitialized. As with SmallVec, StackAlloc backed
+// arrays must not outlive the frame they were allocated in.
+template <typename T>
+class SoAArray {
+public:
+    static constexpr i32 numComponents = SoATraits<T>::numComponents;
+    static constexpr i64 componentAlignment = 64;
+    using Arrays = typename SoATraits<T>::Arrays;
+
+    inline SoAArray();
+    inline SoAArray(i64 num_elems);
+    inline SoAArray(StackAlloc &alloc, i64 num_elems);
+    SoAArray(const SoAArray &) = delete;
+    inline SoAArray(SoAArray &&o);
+    inline ~SoAArray();
+
+    SoAArray & operator=(const SoAArray &) = delete;
+    inline SoAArray & operator=(SoAArray &&o);
+
+    inline i64 size() const { return view_.numElems; }
+    inline float * component(i32 c) const { return view_.components[c]; }
+    inline Arrays arrays() const { return view_.arrays(); }
+    inline SoAView<T> view() const { return view_; }
+
+    inline SoARef<T> operator[](i64 idx) const { return view_[idx]; }
+
+    // Total bytes needed for num_elems elements, including padding
+    static inline i64 bufferSize(i64 num_elems);
+
+private:
+    inline void setComponents(char *buffer);
+
+    SoAView<T> view_;
+    char *buffer_;
+    bool owns_buffer_;
+};
+
+// Transposes num_elems AoS elements from src into dst[0, num_elems)
+template <typename T>
+inline void aosToSoA(SoAView<T> dst, Span<const T> src);
+
+// Transposes src back into AoS order in dst, which must hold src.size()
+// elements
+template <typename T>
+inline void soaToAoS(Span<T> dst, SoAView<T> src);
+
+// Untyped backends for the functions above. Elements are num_components
+// floats; 2, 3, 4 and 6 component elements use SIMD transposes.
+void deinterleaveFloats(float * const *dst_components, const float *src,
+                        i32 num_components, i64 num_elems);
+void interleaveFloats(float *dst, const float * const *src_components,
+                      i32 num_components, i64 num_elems);
+
+}
+
+#include "soa.inl"
@@ -0,0 +1,203 @@
+#include <bit>
+#include <cstring>
+#include <new>
+
+namespace brt {
+
+namespace soa {
+
+template <typename T>
+constexpr inline void checkTraits()
+{
+    constexpr i32 num_components = SoATraits<T>::numComponents;
+
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) == num_components * sizeof(float));
+    static_assert(sizeof(typename SoATraits<T>::Arrays) ==
+                  num_components * sizeof(float *));
+}
+
+}
+
+template <typename T>
+SoARef<T>::SoARef(float * const *components, i64 idx)
+    : components_(components),
+      idx_(idx)
+{}
+
+template <typename T>
+SoARef<T>::operator T() const
+{
+    return get();
+}
+
+template <typename T>
+T SoARef<T>::get() const
+{
+    float vals[numComponents];
+    for (i32 c = 0; c < numComponents; c++) {
+        vals[c] = components_[c][idx_];
+    }
+
+    T v;
+    memcpy(&v, vals, sizeof(T));
+    return v;
+}
+
+template <typename T>
+SoARef<T> & SoARef<T>::operator=(const T &v)
+{
+    float vals[numComponents];
+    memcpy(vals, &v, sizeof(T));
+
+    for (i32 c = 0; c < numComponents; c++) {
+        components_[c][idx_] = vals[c];
+    }
+
+    return *this;
+}
+
+template <typename T>
+float & SoARef<T>::component(i32 c) const
+{
+    return components_[c][idx_];
+}
+
+template <typename T>
+typename SoAView<T>::Arrays SoAView<T>::arrays() const
+{
+    soa::checkTraits<T>();
+
+    return std::bit_cast<Arrays>(components);
+}
+
+template <typename T>
+SoARef<T> SoAView<T>::operator[](i64 idx) const
+{
+    return SoARef<T>(components.data(), idx);
+}
+
+template <typename T>
+SoAView<T> SoAView<T>::subview(i64 offset, i64 num_elems) const
+{
+    SoAView sub;
+    for (i32 c = 0; c < numComponents; c++) {
+        sub.components[c] = components[c] + offset;
+    }
+    sub.numElems = num_elems;
+
+    return sub;
+}
+
+template <typename T>
+SoAArray<T>::SoAArray()
+    : view_ {},
+      buffer_(nullptr),
+      owns_buffer_(false)
+{}
+
+template <typename T>
+SoAArray<T>::SoAArray(i64 num_elems)
+    : view_ {},
+      buffer_((char *)operator new(bufferSize(num_elems),
+          std::align_val_t(componentAlignment))),
+      owns_buffer_(true)
+{
+    view_.numElems = num_elems;
+    setComponents(buffer_);
+}
+
+template <typename T>
+SoAArray<T>::SoAArray(StackAlloc &alloc, i64 num_elems)
+    : view_ {},
+      buffer_((char *)alloc.alloc(bufferSize(num_elems), componentAlignment)),
+      owns_buffer_(false)
+{
+    view_.numElems = num_elems;
+    setComponents(buffer_);
+}
+
+template <typename T>
+SoAArray<T>::SoAArray(SoAArray &&o)
+    : view_(o.view_),
+      buffer_(o.buffer_),
+      owns_buffer_(o.owns_buffer_)
+{
+    o.view_ = {};
+    o.buffer_ = nullptr;
+    o.owns_buffer_ = false;
+}
+
+template <typename T>
+SoAArray<T>::~SoAArray()
+{
+    if (owns_buffer_) {
+        operator delete(buffer_, std::align_val_t(componentAlignment));
+    }
+}
+
+template <typename T>
+SoAArray<T> & SoAArray<T>::operator=(SoAArray &&o)
+{
+    if (owns_buffer_) {
+        operator delete(buffer_, std::align_val_t(componentAlignment));
+    }
+
+    view_ = o.view_;
+    buffer_ = o.buffer_;
+    owns_buffer_ = o.owns_buffer_;
+
+    o.view_ = {};
+    o.buffer_ = nullptr;
+    o.owns_buffer_ = false;
+
+    return *this;
+}
+
+template <typename T>
+i64 SoAArray<T>::bufferSize(i64 num_elems)
+{
+    soa::checkTraits<T>();
+
+    i64 component_bytes = num_elems * (i64)sizeof(float);
+    return numComponents * roundToAlignment(component_bytes,
+                                            componentAlignment);
+}
+
+template <typename T>
+void SoAArray<T>::setComponents(char *buffer)
+{
+    i64 chunk_sizes[numComponents];
+    for (i32 c = 0; c < numComponents; c++) {
+        chunk_sizes[c] = view_.numElems * (i64)sizeof(float);
+    }
+
+    i64 offsets[numComponents - 1];
+    computeBufferOffsets(Span<const i64>(chunk_sizes, numComponents),
+                         offsets, componentAlignment);
+
+    view_.components[0] = (float *)buffer;
+    for (i32 c = 1; c < numComponents; c++) {
+        view_.components[c] = (float *)(buffer + offsets[c - 1]);
+    }
+}
+
+template <typename T>
+void aosToSoA(SoAView<T> dst, Span<const T> src)
+{
+    soa::checkTraits<T>();
+
+    deinterleaveFloats(dst.components.data(), (const float *)src.data(),
+                       SoATraits<T>::numComponents, src.size());
+}
+
+template <typename T>
+void soaToAoS(Span<T> dst, SoAView<T> src)
+{
+    soa::checkTraits<T>();
+
+    interleaveFloats((float *)dst.data(), src.components.data(),
+                     SoATraits<T>::numComponents, src.size());
+}
+
+}
@@ -12,25 +12,26 @@
 
 #include <array>
 #include <initializer_list>
+#include <type_traits>
 
 namespace brt {
 
 template <typename T>
 class Span {
 public:
-  Span() : ptr(nullptr), n(0) {}
+  constexpr Span() : ptr(nullptr), n(0) {}
 
-  Span(T *ptr, i64 num_elems)
+  constexpr Span(T *ptr, i64 num_elems)
     : ptr(ptr), n(num_elems)
   {}
 
   template <i64 N>
-  Span(T (&arr)[N])
+  constexpr Span(T (&arr)[N])
     : ptr(arr), n(N)
   {}
 
   template <typename U, i64 N>
-  Span(const std::array<U, N> &arr)
+  constexpr Span(const std::array<U, N> &arr)
       requires(std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>)
     : ptr(arr.data()), n(N)
   {}
@@ -41,7 +42,8 @@ public:
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Winit-list-lifetime"
 #endif
-  Span(std::initializer_list<std::remove_cv_t<T>> const && init BRT_LFBOUND)
+  constexpr Span(
+      std::initializer_list<std::remove_cv_t<T>> const && init BRT_LFBOUND)
       requires(std::is_const_v<T>)
     : ptr(init.begin()), n(init.size())
   {}
@@ -50,7 +52,7 @@ public:
 #endif
 
   template <typename U>
-  Span(const U &u)
+  constexpr Span(const U &u)
     : ptr(u.data()), n(u.size())
   {}
 
@@ -58,13 +60,200 @@ public:
 
   constexpr i64 size() const { return n; }
 
-  T & operator[](i64 idx) const { return ptr[idx]; }
+  constexpr T & operator[](i64 idx) const { return ptr[idx]; }
 
-  T * begin() const { return ptr; }
-  T * end() const { return ptr + n; }
+  constexpr T * begin() const { return ptr; }
+  constexpr T * end() const { return ptr + n; }
 
   T *ptr;
   i64 n;
 };
 
+// Non contiguous view of num_elems elements spaced stride bytes apart.
+// Byte strides let a StridedSpan view one field of an array of structs:
+//   StridedSpan<const AABB>(aabbs).field(&AABB::pMin)
+template <typename T>
+class StridedSpan {
+public:
+  constexpr StridedSpan() : ptr(nullptr), n(0), stride(0) {}
+
+  constexpr StridedSpan(T *ptr, i64 num_elems, i64 byte_stride)
+    : ptr(ptr), n(num_elems), stride(byte_stride)
+  {}
+
+  template <typename U>
+  constexpr StridedSpan(Span<U> s)
+      requires(std::is_convertible_v<U (*)[], T (*)[]>)
+    : ptr(s.data()), n(s.size()), stride(sizeof(T))
+  {}
+
+  constexpr i64 size() const { return n; }
+  constexpr i64 byteStride() const { return stride; }
+
+  T & operator[](i64 idx) const
+  {
+    using Byte = std::conditional_t<std::is_const_v<T>, const char, char>;
+    return *(T *)((Byte *)ptr + idx * stride);
+  }
+
+  StridedSpan subspan(i64 offset, i64 num_elems) const
+  {
+    return StridedSpan(&(*this)[offset], num_elems, stride);
+  }
+
+  // View of the member field of every element
+  template <typename M, typename S>
+  auto field(M S::*member) const
+      requires(std::is_same_v<S, std::remove_cv_t<T>>)
+  {
+    using FieldT = std::conditional_t<std::is_const_v<T>, const M, M>;
+    FieldT *field_ptr = ptr == nullptr ? nullptr : &(ptr->*member);
+    return StridedSpan<FieldT>(field_ptr, n, stride);
+  }
+
+  class Iter {
+  public:
+    T & operator*() const { return *cur; }
+    Iter & operator++()
+    {
+      using Byte = std::conditional_t<std::is_const_v<T>, const char, char>;
+      cur = (T *)((Byte *)cur + stride);
+      return *this;
+    }
+    bool operator==(const Iter &o) const { return cur == o.cur; }
+
+    T *cur;
+    i64 stride;
+  };
+
+  Iter begin() const { return Iter { ptr, stride }; }
+  Iter end() const { return Iter { n == 0 ? ptr : &(*this)[n], stride }; }
+
+  T *ptr;
+  i64 n;
+  i64 stride;
+};
+
+// Rank dimensional view over elements with per dimension extents and byte
+// strides. The last dimension varies fastest for views built from extents
+// alone (row major). Subviews and slices share the underlying memory.
+template <typename T, i32 Rank>
+class MDSpan {
+public:
+  static_assert(Rank > 0);
+
+  using Extents = std::array<i64, Rank>;
+
+  constexpr MDSpan() : ptr(nullptr), extents(), strides() {}
+
+  // Densely packed row major data
+  constexpr MDSpan(T *ptr, Extents extents)
+    : ptr(ptr), extents(extents), strides()
+  {
+    i64 stride = sizeof(T);
+    for (i32 d = Rank - 1; d >= 0; d--) {
+      strides[d] = stride;
+      stride *= extents[d];
+    }
+  }
+
+  constexpr MDSpan(T *ptr, Extents extents, Extents byte_strides)
+    : ptr(ptr), extents(extents), strides(byte_strides)
+  {}
+
+  // s must contain at least the product of extents elements
+  template <typename U>
+  constexpr MDSpan(Span<U> s, Extents extents)
+      requires(std::is_convertible_v<U (*)[], T (*)[]>)
+    : MDSpan(s.data(), extents)
+  {}
+
+  constexpr i64 extent(i32 dim) const { return extents[dim]; }
+  constexpr i64 byteStride(i32 dim) const { return strides[dim]; }
+
+  constexpr i64 size() const
+  {
+    i64 num_elems = 1;
+    for (i32 d = 0; d < Rank; d++) {
+      num_elems *= extents[d];
+    }
+    return num_elems;
+  }
+
+  template <typename... Idxs>
+  T & operator()(Idxs... idxs) const
+      requires(sizeof...(Idxs) == Rank)
+  {
+    i64 offset = 0;
+    i32 d = 0;
+    ((offset += (i64)idxs * strides[d++]), ...);
+
+    return *(T *)((Byte *)ptr + offset);
+  }
+
+  // Box of the given extents starting at offsets
+  MDSpan subview(Extents offsets, Extents sub_extents) const
+  {
+    i64 offset = 0;
+    for (i32 d = 0; d < Rank; d++) {
+      offset += offsets[d] * strides[d];
+    }
+
+    return MDSpan((T *)((Byte *)ptr + offset), sub_extents, strides);
+  }
+
+  // Fixes dimension dim at idx, e.g. one z slab of a 3D grid
+  MDSpan<T, Rank - 1> slice(i32 dim, i64 idx) const
+      requires(Rank > 1)
+  {
+    std::array<i64, Rank - 1> sub_extents;
+    std::array<i64, Rank - 1> sub_strides;
+    for (i32 d = 0, o = 0; d < Rank; d++) {
+      if (d != dim) {
+        sub_extents[o] = extents[d];
+        sub_strides[o] = strides[d];
+        o++;
+      }
+    }
+
+    return MDSpan<T, Rank - 1>((T *)((Byte *)ptr + idx * strides[dim]),
+                               sub_extents, sub_strides);
+  }
+
+  StridedSpan<T> strided() const
+      requires(Rank == 1)
+  {
+    return StridedSpan<T>(ptr, extents[0], strides[0]);
+  }
+
+  // True if the elements are densely packed in row major order
+  constexpr bool isContiguous() const
+  {
+    i64 stride = sizeof(T);
+    for (i32 d = Rank - 1; d >= 0; d--) {
+      if (extents[d] != 1 && strides[d] != stride) {
+        return false;
+      }
+      stride *= extents[d];
+    }
+    return true;
+  }
+
+  template <typename M, typename S>
+  auto field(M S::*member) const
+      requires(std::is_same_v<S, std::remove_cv_t<T>>)
+  {
+    using FieldT = std::conditional_t<std::is_const_v<T>, const M, M>;
+    FieldT *field_ptr = ptr == nullptr ? nullptr : &(ptr->*member);
+    return MDSpan<FieldT, Rank>(field_ptr, extents, strides);
+  }
+
+  T *ptr;
+  Extents extents;
+  Extents strides;
+
+private:
+  using Byte = std::conditional_t<std::is_const_v<T>, const char, char>;
+};
+
 }
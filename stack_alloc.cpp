@@ -4,8 +4,10 @@
 
 namespace brt {
 
-static void * allocAligned(size_t num_bytes, size_t alignment)
+void * allocAligned(size_t num_bytes, size_t alignment)
 {
+    num_bytes = roundUpPow2(num_bytes, alignment);
+
 #if defined(_LIBCPP_VERSION)
     return std::aligned_alloc(alignment, num_bytes);
 #elif defined(BRT_CXX_MSVC)
@@ -15,7 +17,7 @@ static void * allocAligned(size_t num_bytes, size_t alignment)
 #endif
 }
 
-static void deallocAligned(void *ptr)
+void deallocAligned(void *ptr)
 {
 #if defined(_LIBCPP_VERSION)
     free(ptr);
@@ -45,6 +47,13 @@ void StackAlloc::pop(AllocFrame frame)
     uintptr_t mask = chunk_size_ - 1;
     uintptr_t cur_offset = (uintptr_t)frame.ptr & mask;
 
+    // Chunks start with their metadata, so no frame is ever at offset 0.
+    // Such a frame was pushed when the current chunk was full (or held an
+    // oversized allocation) and points at its end, not at the next chunk.
+    if (cur_offset == 0) {
+        cur_offset = chunk_size_;
+    }
+
     void *chunk_start = (char *)frame.ptr - cur_offset;
     auto *metadata = (ChunkMetadata *)chunk_start;
 
@@ -5,6 +5,12 @@
 
 namespace brt {
 
+// System allocations aligned to a power of two alignment, used for
+// StackAlloc chunks and file buffers. num_bytes is rounded up to a
+// multiple of alignment. Free with deallocAligned.
+void * allocAligned(size_t num_bytes, size_t alignment);
+void deallocAligned(void *ptr);
+
 struct AllocFrame {
     void *ptr;
 };
@@ -32,6 +38,11 @@ public:
     template <typename T>
     T * allocN(u64 num_elems);
 
+    // Extends the allocation at ptr to new_num_bytes without moving it.
+    // Only succeeds if ptr is the most recent allocation and the current
+    // chunk has room.
+    inline bool growInPlace(void *ptr, u64 old_num_bytes, u64 new_num_bytes);
+
 private:
     struct ChunkMetadata {
         ChunkMetadata *next;
@@ -80,6 +80,23 @@ void * StackAlloc::alloc(u64 num_bytes, u64 alignment)
     return new_chunk + alloc_offset;
 }
 
+bool StackAlloc::growInPlace(void *ptr, u64 old_num_bytes,
+                             u64 new_num_bytes)
+{
+    char *end = (char *)ptr + old_num_bytes;
+    if (end != cur_chunk_ + chunk_offset_) {
+        return false;
+    }
+
+    u64 new_offset = (u64)((char *)ptr - cur_chunk_) + new_num_bytes;
+    if (new_offset > chunk_size_) {
+        return false;
+    }
+
+    chunk_offset_ = new_offset;
+    return true;
+}
+
 template <typename T>
 T * StackAlloc::alloc()
 {
@@ -0,0 +1,172 @@
+#include <brt/string.hpp>
+#include <brt/err.hpp>
+#include <brt/hash.hpp>
+#include <brt/sync.hpp>
+#include <brt/utils.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace brt {
+
+StringInterner::StringInterner(u32 initial_capacity)
+    : table_(new Table {
+          .prev = nullptr,
+          .slots = nullptr,
+          .mask = u32NextPow2(std::max(initial_capacity, 16_u32)) - 1,
+      }),
+      arena_(),
+      lock_(0),
+      num_entries_(0)
+{
+    table_->slots = (Slot *)calloc(table_->mask + 1, sizeof(Slot));
+}
+
+StringInterner::~StringInterner()
+{
+    Table *tbl = table_;
+    while (tbl != nullptr) {
+        Table *prev = tbl->prev;
+        free(tbl->slots);
+        delete tbl;
+        tbl = prev;
+    }
+}
+
+StringID StringInterner::intern(const char *str, i64 len)
+{
+    u32 hash = fnv1aHash(str, len);
+
+    const Table *tbl = AtomicRef<Table *>(table_).load_acquire();
+    const Slot *slot = find(tbl, str, len, hash);
+    if (slot != nullptr) [[likely]] {
+        return { slot->ptr, hash };
+    }
+
+    return insert(str, len, hash);
+}
+
+StringID StringInterner::intern(const char *str)
+{
+    return intern(str, (i64)strlen(str));
+}
+
+StringID StringInterner::intern(StringID id)
+{
+    i64 len = (i64)strlen(id.ptr);
+
+    const Table *tbl = AtomicRef<Table *>(table_).load_acquire();
+    const Slot *slot = find(tbl, id.ptr, len, id.hash);
+    if (slot != nullptr) [[likely]] {
+        return { slot->ptr, id.hash };
+    }
+
+    return insert(id.ptr, len, id.hash);
+}
+
+StringID StringInterner::lookup(const char *str, i64 len) const
+{
+    u32 hash = fnv1aHash(str, len);
+
+    const Table *tbl = AtomicRef<Table *>(
+        const_cast<Table *&>(table_)).load_acquire();
+    const Slot *slot = find(tbl, str, len, hash);
+
+    return { slot ? slot->ptr : nullptr, hash };
+}
+
+i64 StringInterner::size() const
+{
+    return AtomicU32Ref(const_cast<u32 &>(num_entries_)).load_relaxed();
+}
+
+const StringInterner::Slot * StringInterner::find(
+    const Table *tbl, const char *str, i64 len, u32 hash)
+{
+    u32 idx = hash & tbl->mask;
+    while (true) {
+        const Slot *slot = &tbl->slots[idx];
+
+        // Slots are written once: hash and len are stored before ptr is
+        // released, so they are safe to read after acquiring ptr.
+        const char *ptr = AtomicRef<const char *>(
+            const_cast<const char *&>(slot->ptr)).load_acquire();
+        if (ptr == nullptr) {
+            return nullptr;
+        }
+
+        if (slot->hash == hash && slot->len == (u32)len &&
+                memcmp(ptr, str, len) == 0) {
+            return slot;
+        }
+
+        idx = (idx + 1) & tbl->mask;
+    }
+}
+
+StringID StringInterner::insert(const char *str, i64 len, u32 hash)
+{
+    spinLock(&lock_);
+    BRT_DEFER(spinUnlock(&lock_));
+
+    // Another thread may have inserted str while we waited on the lock
+    const Slot *existing = find(table_, str, len, hash);
+    if (existing != nullptr) {
+        return { existing->ptr, hash };
+    }
+
+    if ((num_entries_ + 1) * 2 > table_->mask + 1) {
+        grow();
+    }
+
+    char *copy = arena_.allocN<char>(len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    u32 idx = hash & table_->mask;
+    while (table_->slots[idx].ptr != nullptr) {
+        idx = (idx + 1) & table_->mask;
+    }
+
+    Slot &slot = table_->slots[idx];
+    slot.hash = hash;
+    slot.len = (u32)len;
+    AtomicRef<const char *>(slot.ptr).store_release(copy);
+
+    AtomicU32Ref(num_entries_).store_relaxed(num_entries_ + 1);
+
+    return { copy, hash };
+}
+
+void StringInterner::grow()
+{
+    Table *old_tbl = table_;
+    u32 new_capacity = (old_tbl->mask + 1) * 2;
+
+    // Readers may still be probing old tables, so they are only freed
+    // when the interner is destroyed.
+    Table *new_tbl = new Table {
+        .prev = old_tbl,
+        .slots = (Slot *)calloc(new_capacity, sizeof(Slot)),
+        .mask = new_capacity - 1,
+    };
+
+    for (u32 i = 0; i <= old_tbl->mask; i++) {
+        const Slot &old_slot = old_tbl->slots[i];
+        if (old_slot.ptr == nullptr) {
+            continue;
+        }
+
+        u32 idx = old_slot.hash & new_tbl->mask;
+        while (new_tbl->slots[idx].ptr != nullptr) {
+            idx = (idx + 1) & new_tbl->mask;
+        }
+
+        new_tbl->slots[idx] = old_slot;
+    }
+
+    AtomicRef<Table *>(table_).store_release(new_tbl);
+}
+
+}
@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 
+#include <brt/types.hpp>
+#include <brt/stack_alloc.hpp>
+
 namespace brt {
 
 constexpr uint32_t compileHash(
@@ -25,4 +28,51 @@ inline constexpr StringID operator""_hash(
   };
 }
 
+// Thread safe table of canonical runtime strings. The StringIDs returned
+// by intern() have the same hash as the equivalent _hash literal, and
+// two interned StringIDs refer to the same string iff their ptrs are equal.
+// Lookups of already interned strings never take a lock.
+class StringInterner {
+public:
+    StringInterner(u32 initial_capacity = 1024);
+    StringInterner(const StringInterner &) = delete;
+    ~StringInterner();
+
+    StringInterner & operator=(const StringInterner &) = delete;
+
+    // Returned ptrs are null terminated and stable for the lifetime of the
+    // interner.
+    StringID intern(const char *str, i64 len);
+    StringID intern(const char *str);
+    StringID intern(StringID id);
+
+    // Returns { nullptr, hash } if str has not been interned.
+    StringID lookup(const char *str, i64 len) const;
+
+    i64 size() const;
+
+private:
+    struct Slot {
+        const char *ptr;
+        u32 hash;
+        u32 len;
+    };
+
+    struct Table {
+        Table *prev;
+        Slot *slots;
+        u32 mask;
+    };
+
+    static const Slot * find(const Table *tbl, const char *str, i64 len,
+                             u32 hash);
+    StringID insert(const char *str, i64 len, u32 hash);
+    void grow();
+
+    Table *table_;
+    StackAlloc arena_;
+    u32 lock_;
+    u32 num_entries_;
+};
+
 }
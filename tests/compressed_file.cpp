@@ -0,0 +1,84 @@
+#include <brt/compressed_file.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+using namespace brt;
+
+namespace {
+
+constexpr i64 block_bytes = 256 * 1024;
+constexpr i64 num_blocks = 3;
+
+void writeTestFile(const char *path)
+{
+    char *data = new char[block_bytes * num_blocks];
+    for (i64 i = 0; i < block_bytes * num_blocks; i++) {
+        data[i] = (char)((i * 7) ^ (i >> 9));
+    }
+
+    CompressedFileWriter out(path);
+    ASSERT_TRUE(out.isOpen());
+    ASSERT_TRUE(out.write(
+        Span<const char>(data, block_bytes * num_blocks)));
+    ASSERT_TRUE(out.close());
+
+    delete[] data;
+}
+
+// Flips one stored byte of block block_idx
+void corruptBlock(const char *path, i64 block_idx)
+{
+    FILE *f = fopen(path, "r+b");
+    ASSERT_NE(f, nullptr);
+
+    CompressedFileHeader header;
+    ASSERT_EQ(fread(&header, sizeof(header), 1, f), 1u);
+
+    CompressedBlockEntry entry;
+    fseek(f, (long)(header.indexOffset +
+                    block_idx * sizeof(CompressedBlockEntry)), SEEK_SET);
+    ASSERT_EQ(fread(&entry, sizeof(entry), 1, f), 1u);
+
+    u8 b;
+    fseek(f, (long)entry.offset + 10, SEEK_SET);
+    ASSERT_EQ(fread(&b, 1, 1, f), 1u);
+    b ^= 1;
+    fseek(f, (long)entry.offset + 10, SEEK_SET);
+    ASSERT_EQ(fwrite(&b, 1, 1, f), 1u);
+
+    fclose(f);
+}
+
+}
+
+TEST(CompressedFile, CorruptBlockAfterOversizedBlock)
+{
+    std::string path = testing::TempDir() + "brt_corrupt_block.brtz";
+    writeTestFile(path.c_str());
+    corruptBlock(path.c_str(), 1);
+
+    CompressedFileReader in(path.c_str());
+    ASSERT_TRUE(in.isOpen());
+    ASSERT_EQ(in.numBlocks(), num_blocks);
+
+    // Blocks are larger than the arena's default chunk, so each decode
+    // leaves the current chunk full
+    StackAlloc arena;
+    AllocFrame frame = arena.push();
+
+    Span<char> block = in.readBlock(0, arena);
+    EXPECT_EQ(block.size(), block_bytes);
+
+    EXPECT_EQ(in.readBlock(1, arena).size(), 0);
+
+    Span<char> last = in.readBlock(2, arena);
+    EXPECT_EQ(last.size(), block_bytes);
+    EXPECT_EQ(last[0], (char)((2 * block_bytes * 7) ^ (2 * block_bytes >> 9)));
+
+    arena.pop(frame);
+
+    remove(path.c_str());
+}
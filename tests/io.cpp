@@ -0,0 +1,29 @@
+#include <brt/io.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace brt;
+
+TEST(IO, ReadBinaryFileArenaFailureAfterOversizedAlloc)
+{
+    StackAlloc arena(4096);
+    AllocFrame outer = arena.push();
+
+    // Leaves the current chunk full
+    char *big = (char *)arena.alloc(10000, 64);
+    memset(big, 1, 10000);
+
+    AllocFrame frame = arena.push();
+
+    // Opening a directory succeeds, reading it fails
+    std::string dir = testing::TempDir();
+    size_t num_bytes = 0;
+    EXPECT_EQ(readBinaryFile(dir.c_str(), arena, 64, &num_bytes), nullptr);
+
+    EXPECT_EQ(big[9999], 1);
+    EXPECT_EQ(arena.push().ptr, frame.ptr);
+
+    arena.pop(outer);
+}
@@ -0,0 +1,46 @@
+#include <brt/parse.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace brt;
+
+namespace {
+
+i64 parseU64(const char *str, u64 *out)
+{
+    return brt::parseU64(Span<const char>(str, (i64)strlen(str)), out);
+}
+
+}
+
+TEST(Parse, U64)
+{
+    u64 v = 0;
+    EXPECT_EQ(parseU64("0", &v), 1);
+    EXPECT_EQ(v, 0u);
+    EXPECT_EQ(parseU64("12345678901234,", &v), 14);
+    EXPECT_EQ(v, 12345678901234u);
+    EXPECT_EQ(parseU64("00000000000000000000042", &v), 23);
+    EXPECT_EQ(v, 42u);
+    EXPECT_EQ(parseU64("x", &v), 0);
+}
+
+TEST(Parse, U64Limits)
+{
+    u64 v = 0;
+    EXPECT_EQ(parseU64("18446744073709551615", &v), 20);
+    EXPECT_EQ(v, 18446744073709551615u);
+    EXPECT_EQ(parseU64("10000000000000000000", &v), 20);
+    EXPECT_EQ(v, 10000000000000000000u);
+
+    EXPECT_EQ(parseU64("18446744073709551616", &v), 0);
+    EXPECT_EQ(parseU64("18446744073709551620", &v), 0);
+    EXPECT_EQ(parseU64("99999999999999999999", &v), 0);
+    EXPECT_EQ(parseU64("100000000000000000000", &v), 0);
+
+    // Wrap to values above 1e19
+    EXPECT_EQ(parseU64("28446744073709551616", &v), 0);
+    EXPECT_EQ(parseU64("36893488147419103231", &v), 0);
+}
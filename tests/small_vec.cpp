@@ -0,0 +1,55 @@
+#include <brt/small_vec.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace brt;
+
+namespace {
+
+// Non trivially relocatable, so a read from a moved-from or freed element
+// is visible
+struct Boxed {
+    i64 *v;
+
+    Boxed(i64 x) : v(new i64(x)) {}
+    Boxed(const Boxed &o) : v(new i64(*o.v)) {}
+    Boxed(Boxed &&o) : v(o.v) { o.v = nullptr; }
+    ~Boxed() { delete v; }
+
+    Boxed & operator=(const Boxed &) = delete;
+};
+
+}
+
+TEST(SmallVec, PushOwnElementWhileFull)
+{
+    SmallVec<Boxed, 2> v;
+    v.push(Boxed(1));
+    v.push(Boxed(2));
+    v.push(v[0]);
+    v.push(v[1]);
+    v.emplace(v[3]);
+
+    ASSERT_EQ(v.size(), 5);
+    EXPECT_EQ(*v[0].v, 1);
+    EXPECT_EQ(*v[1].v, 2);
+    EXPECT_EQ(*v[2].v, 1);
+    EXPECT_EQ(*v[3].v, 2);
+    EXPECT_EQ(*v[4].v, 2);
+}
+
+TEST(SmallVec, PushOwnElementWhileFullArena)
+{
+    StackAlloc alloc;
+    SmallVec<i64, 1> v(alloc);
+    v.push(7);
+
+    for (i64 i = 0; i < 100; i++) {
+        v.push(v[i]);
+    }
+
+    ASSERT_EQ(v.size(), 101);
+    for (i64 x : v) {
+        EXPECT_EQ(x, 7);
+    }
+}
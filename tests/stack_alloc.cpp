@@ -0,0 +1,45 @@
+#include <brt/stack_alloc.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace brt;
+
+TEST(StackAlloc, PopAfterFullChunk)
+{
+    StackAlloc arena(4096);
+
+    AllocFrame outer = arena.push();
+    arena.alloc(4096 - 64, 64);
+
+    // The chunk is exactly full, so the frame points at its end
+    AllocFrame frame = arena.push();
+    arena.alloc(100, 16);
+    arena.pop(frame);
+
+    EXPECT_EQ(arena.push().ptr, frame.ptr);
+    EXPECT_NE(arena.alloc(100, 16), nullptr);
+
+    arena.pop(outer);
+}
+
+TEST(StackAlloc, PopAfterOversizedAlloc)
+{
+    StackAlloc arena(4096);
+
+    AllocFrame outer = arena.push();
+    char *big = (char *)arena.alloc(10000, 64);
+    memset(big, 1, 10000);
+
+    AllocFrame frame = arena.push();
+    arena.alloc(100, 16);
+    arena.alloc(20000, 16);
+    arena.pop(frame);
+
+    // The oversized allocation survives and stays the current chunk
+    EXPECT_EQ(big[0], 1);
+    EXPECT_EQ(big[9999], 1);
+    EXPECT_EQ(arena.push().ptr, frame.ptr);
+    EXPECT_NE(arena.alloc(100, 16), nullptr);
+
+    arena.pop(outer);
+}
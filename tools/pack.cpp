@@ -0,0 +1,239 @@
+#include <brt/compressed_file.hpp>
+#include <brt/io.hpp>
+#include <brt/stack_alloc.hpp>
+#include <brt/sync.hpp>
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace brt;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Minimal ParallelFor: num_threads threads, including the caller, claim
+// task indices until none are left
+struct ThreadParallelFor {
+    i32 numThreads;
+
+    static void run(void *ctx, i64 num_tasks,
+                    void (*task)(void *task_data, i64 task_idx),
+                    void *task_data)
+    {
+        i32 num_threads = ((ThreadParallelFor *)ctx)->numThreads;
+
+        AtomicI64 next_task(0);
+        auto worker = [&]() {
+            i64 task_idx;
+            while ((task_idx = next_task.fetch_add_relaxed(1)) < num_tasks) {
+                task(task_data, task_idx);
+            }
+        };
+
+        std::thread *threads = new std::thread[num_threads - 1];
+        for (i32 i = 0; i < num_threads - 1; i++) {
+            threads[i] = std::thread(worker);
+        }
+
+        worker();
+
+        for (i32 i = 0; i < num_threads - 1; i++) {
+            threads[i].join();
+        }
+        delete[] threads;
+    }
+};
+
+int pack(const char *in_path, const char *out_path, i64 block_bytes)
+{
+    StreamReader in(in_path);
+    if (!in.isOpen()) {
+        fprintf(stderr, "Failed to open %s\n", in_path);
+        return 1;
+    }
+
+    CompressedFileConfig cfg;
+    cfg.blockBytes = block_bytes;
+
+    CompressedFileWriter out(out_path, cfg);
+    if (!out.isOpen()) {
+        fprintf(stderr, "Failed to create %s\n", out_path);
+        return 1;
+    }
+
+    auto start = Clock::now();
+
+    Span<const char> block;
+    while ((block = in.next()).size() > 0) {
+        if (!out.write(block)) {
+            break;
+        }
+    }
+
+    i64 compressed_bytes = out.compressedSize();
+    if (in.failed() || !out.close()) {
+        fprintf(stderr, "Failed to write %s\n", out_path);
+        return 1;
+    }
+
+    double secs = secondsSince(start);
+    printf("%lld -> %lld bytes (%.3fx), %.1f MB/s\n",
+           (long long)in.size(), (long long)compressed_bytes,
+           (double)in.size() / (double)std::max(compressed_bytes, (i64)1),
+           (double)in.size() / secs / 1e6);
+
+    return 0;
+}
+
+int unpack(const char *in_path, const char *out_path)
+{
+    CompressedFileReader in(in_path);
+    if (!in.isOpen()) {
+        fprintf(stderr, "Failed to open %s\n", in_path);
+        return 1;
+    }
+
+    // Only replaces out_path once every block decoded
+    BinaryWriterConfig out_cfg;
+    out_cfg.atomicReplace = true;
+
+    BinaryWriter out(out_path, out_cfg);
+    if (!out.isOpen()) {
+        fprintf(stderr, "Failed to create %s\n", out_path);
+        return 1;
+    }
+
+    // One block in memory at a time
+    StackAlloc arena(std::bit_ceil((u64)in.blockBytes() + 4096));
+    for (i64 i = 0; i < in.numBlocks(); i++) {
+        AllocFrame frame = arena.push();
+
+        Span<char> block = in.readBlock(i, arena);
+        if (block.size() == 0) {
+            fprintf(stderr, "Block %lld is corrupt\n", (long long)i);
+            out.abort();
+            return 1;
+        }
+
+        bool success =
+            out.write(Span<const char>(block.data(), block.size()));
+        arena.pop(frame);
+
+        if (!success) {
+            break;
+        }
+    }
+
+    if (!out.close()) {
+        fprintf(stderr, "Failed to write %s\n", out_path);
+        return 1;
+    }
+
+    return 0;
+}
+
+int bench(const char *path, i32 num_threads)
+{
+    CompressedFileReader in(path);
+    if (!in.isOpen()) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+
+    char *dst = (char *)allocAligned(std::max(in.size(), (i64)1), 64);
+
+    // Fault in the destination and the mapping before timing
+    if (!in.read(0, { dst, in.size() })) {
+        fprintf(stderr, "%s is corrupt\n", path);
+        return 1;
+    }
+
+    ThreadParallelFor threads { num_threads };
+    ParallelFor parallel_for { &threads, ThreadParallelFor::run };
+
+    constexpr i32 num_runs = 5;
+
+    for (i32 threaded = 0; threaded < 2; threaded++) {
+        double best = 1e30;
+        for (i32 run = 0; run < num_runs; run++) {
+            auto start = Clock::now();
+            in.read(0, { dst, in.size() },
+                    threaded ? &parallel_for : nullptr);
+            best = std::min(best, secondsSince(start));
+        }
+
+        printf("decode, %d thread(s): %.2f GB/s\n",
+               threaded ? num_threads : 1, (double)in.size() / best / 1e9);
+    }
+
+    // Random 4KB reads, each decoding one or two blocks
+    constexpr i64 read_bytes = 4096;
+    constexpr i32 num_reads = 10000;
+
+    if (in.size() >= read_bytes) {
+        u64 rng_state = 5;
+        auto start = Clock::now();
+        for (i32 i = 0; i < num_reads; i++) {
+            rng_state = rng_state * 6364136223846793005ull +
+                1442695040888963407ull;
+            i64 offset = (i64)((rng_state >> 16) %
+                               (u64)(in.size() - read_bytes + 1));
+            in.read(offset, { dst, read_bytes });
+        }
+
+        printf("random %lld byte reads: %.1f us\n", (long long)read_bytes,
+               secondsSince(start) / num_reads * 1e6);
+    }
+
+    deallocAligned(dst);
+
+    return 0;
+}
+
+void usage()
+{
+    fprintf(stderr,
+        "usage: brt-pack pack <input> <output> [block KB]\n"
+        "       brt-pack unpack <input> <output>\n"
+        "       brt-pack bench <input> [threads]\n");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "pack") && argc >= 4) {
+        i64 block_bytes = argc >= 5 ? atoll(argv[4]) * 1024 : 256 * 1024;
+        if (block_bytes <= 0 || block_bytes > maxCompressedBlockBytes) {
+            usage();
+            return 1;
+        }
+
+        return pack(argv[2], argv[3], block_bytes);
+    } else if (!strcmp(argv[1], "unpack") && argc >= 4) {
+        return unpack(argv[2], argv[3]);
+    } else if (!strcmp(argv[1], "bench")) {
+        i32 num_threads = argc >= 4 ? atoi(argv[3]) :
+            (i32)std::thread::hardware_concurrency();
+
+        return bench(argv[2], std::max(num_threads, 1));
+    }
+
+    usage();
+    return 1;
+}
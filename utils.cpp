@@ -1,7 +1,271 @@
 #include "utils.hpp"
 
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace brt {
 
+namespace {
+
+#if defined(__AVX__)
+using MemVec = __m256i;
+
+BRT_ALWAYS_INLINE inline MemVec loadVec(const void *src)
+{
+    return _mm256_loadu_si256((const __m256i *)src);
+}
+
+BRT_ALWAYS_INLINE inline MemVec zeroVec()
+{
+    return _mm256_setzero_si256();
+}
+
+// dst must be aligned to sizeof(MemVec)
+template <bool stream>
+BRT_ALWAYS_INLINE inline void storeVec(void *dst, MemVec v)
+{
+    if constexpr (stream) {
+        _mm256_stream_si256((__m256i *)dst, v);
+    } else {
+        _mm256_store_si256((__m256i *)dst, v);
+    }
+}
+#elif defined(__SSE2__)
+using MemVec = __m128i;
+
+BRT_ALWAYS_INLINE inline MemVec loadVec(const void *src)
+{
+    return _mm_loadu_si128((const __m128i *)src);
+}
+
+BRT_ALWAYS_INLINE inline MemVec zeroVec()
+{
+    return _mm_setzero_si128();
+}
+
+template <bool stream>
+BRT_ALWAYS_INLINE inline void storeVec(void *dst, MemVec v)
+{
+    if constexpr (stream) {
+        _mm_stream_si128((__m128i *)dst, v);
+    } else {
+        _mm_store_si128((__m128i *)dst, v);
+    }
+}
+#elif defined(__ARM_NEON)
+using MemVec = uint8x16_t;
+
+BRT_ALWAYS_INLINE inline MemVec loadVec(const void *src)
+{
+    return vld1q_u8((const u8 *)src);
+}
+
+BRT_ALWAYS_INLINE inline MemVec zeroVec()
+{
+    return vdupq_n_u8(0);
+}
+
+// NEON has no streaming store intrinsic, regular stores are used
+template <bool>
+BRT_ALWAYS_INLINE inline void storeVec(void *dst, MemVec v)
+{
+    vst1q_u8((u8 *)dst, v);
+}
+#else
+struct MemVec {
+    u64 v[2];
+};
+
+BRT_ALWAYS_INLINE inline MemVec loadVec(const void *src)
+{
+    MemVec v;
+    memcpy(&v, src, sizeof(MemVec));
+    return v;
+}
+
+BRT_ALWAYS_INLINE inline MemVec zeroVec()
+{
+    return MemVec {};
+}
+
+template <bool>
+BRT_ALWAYS_INLINE inline void storeVec(void *dst, MemVec v)
+{
+    memcpy(dst, &v, sizeof(MemVec));
+}
+#endif
+
+constexpr i64 vec_bytes = sizeof(MemVec);
+constexpr i64 parallel_task_bytes = 4 * 1024 * 1024;
+
+inline void storeFence()
+{
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
+
+template <typename Fn>
+void parallelChunks(const ParallelFor &parallel_for, i64 num_elems,
+                    i64 elems_per_task, const Fn &fn)
+{
+    i64 num_tasks = divideRoundUp(num_elems, elems_per_task);
+
+    runParallel(parallel_for, num_tasks, [&](i64 task_idx) {
+        i64 start = task_idx * elems_per_task;
+        i64 end = start + elems_per_task;
+        if (end > num_elems) {
+            end = num_elems;
+        }
+
+        fn(start, end - start);
+    });
+}
+
+template <bool stream>
+void fillPatternImpl(u8 *dst, const void *pattern, i64 pattern_bytes,
+                     i64 num_elems)
+{
+    const i64 num_bytes = pattern_bytes * num_elems;
+    u8 *end = dst + num_bytes;
+
+    auto fillElems = [&](i64 start, i64 end_idx) {
+        for (i64 i = start; i < end_idx; i++) {
+            memcpy(dst + i * pattern_bytes, pattern, pattern_bytes);
+        }
+    };
+
+    u8 *aligned = (u8 *)alignPtr(dst, vec_bytes);
+    if (aligned + 4 * vec_bytes > end) {
+        fillElems(0, num_elems);
+        return;
+    }
+
+    // Patterns that divide the vector width repeat every vector, 12 byte
+    // patterns repeat every 3 vectors.
+    const i64 block_vecs = (vec_bytes % pattern_bytes == 0) ? 1 : 3;
+    const i64 block_bytes = block_vecs * vec_bytes;
+
+    // Build the block starting at the pattern phase of the first aligned
+    // address so full vectors can be stored with aligned stores.
+    alignas(MemVec) u8 block[3 * vec_bytes + 16];
+    i64 phase = (aligned - dst) % pattern_bytes;
+    for (i64 i = 0; i < block_bytes + pattern_bytes; i += pattern_bytes) {
+        memcpy(block + i, pattern, pattern_bytes);
+    }
+
+    MemVec v0 = loadVec(block + phase);
+
+    fillElems(0, divideRoundUp<i64>(aligned - dst, pattern_bytes));
+
+    u8 *cur = aligned;
+    if (block_vecs == 1) {
+        for (; cur + 4 * vec_bytes <= end; cur += 4 * vec_bytes) {
+            storeVec<stream>(cur, v0);
+            storeVec<stream>(cur + vec_bytes, v0);
+            storeVec<stream>(cur + 2 * vec_bytes, v0);
+            storeVec<stream>(cur + 3 * vec_bytes, v0);
+        }
+
+        for (; cur + vec_bytes <= end; cur += vec_bytes) {
+            storeVec<stream>(cur, v0);
+        }
+    } else {
+        // Only 3 vector blocks initialize the bytes past the first vector
+        MemVec v1 = loadVec(block + phase + vec_bytes);
+        MemVec v2 = loadVec(block + phase + 2 * vec_bytes);
+
+        for (; cur + block_bytes <= end; cur += block_bytes) {
+            storeVec<stream>(cur, v0);
+            storeVec<stream>(cur + vec_bytes, v1);
+            storeVec<stream>(cur + 2 * vec_bytes, v2);
+        }
+
+        if (cur + vec_bytes <= end) {
+            storeVec<stream>(cur, v0);
+            cur += vec_bytes;
+        }
+
+        if (cur + vec_bytes <= end) {
+            storeVec<stream>(cur, v1);
+            cur += vec_bytes;
+        }
+    }
+
+    if constexpr (stream) {
+        storeFence();
+    }
+
+    fillElems((cur - dst) / pattern_bytes, num_elems);
+}
+
+template <bool stream>
+void copyBytesImpl(u8 *dst, const u8 *src, i64 num_bytes)
+{
+    u8 *end = dst + num_bytes;
+    u8 *aligned = (u8 *)alignPtr(dst, vec_bytes);
+    if (aligned + 4 * vec_bytes > end) {
+        memcpy(dst, src, num_bytes);
+        return;
+    }
+
+    i64 head_bytes = aligned - dst;
+    memcpy(dst, src, head_bytes);
+    src += head_bytes;
+
+    u8 *cur = aligned;
+    for (; cur + 4 * vec_bytes <= end; cur += 4 * vec_bytes) {
+        MemVec v0 = loadVec(src);
+        MemVec v1 = loadVec(src + vec_bytes);
+        MemVec v2 = loadVec(src + 2 * vec_bytes);
+        MemVec v3 = loadVec(src + 3 * vec_bytes);
+        storeVec<stream>(cur, v0);
+        storeVec<stream>(cur + vec_bytes, v1);
+        storeVec<stream>(cur + 2 * vec_bytes, v2);
+        storeVec<stream>(cur + 3 * vec_bytes, v3);
+        src += 4 * vec_bytes;
+    }
+
+    if constexpr (stream) {
+        storeFence();
+    }
+
+    memcpy(cur, src, end - cur);
+}
+
+template <bool stream>
+void zeroBytesImpl(u8 *dst, i64 num_bytes)
+{
+    u8 *end = dst + num_bytes;
+    u8 *aligned = (u8 *)alignPtr(dst, vec_bytes);
+    if (aligned + 4 * vec_bytes > end) {
+        memset(dst, 0, num_bytes);
+        return;
+    }
+
+    memset(dst, 0, aligned - dst);
+
+    const MemVec zero = zeroVec();
+    u8 *cur = aligned;
+    for (; cur + 4 * vec_bytes <= end; cur += 4 * vec_bytes) {
+        storeVec<stream>(cur, zero);
+        storeVec<stream>(cur + vec_bytes, zero);
+        storeVec<stream>(cur + 2 * vec_bytes, zero);
+        storeVec<stream>(cur + 3 * vec_bytes, zero);
+    }
+
+    if constexpr (stream) {
+        storeFence();
+    }
+
+    memset(cur, 0, end - cur);
+}
+
+}
+
 // https://lemire.me/blog/2021/06/03/computing-the-number-of-digits-of-an-integer-even-faster/
 i32 u32NumDigits(u32 x)
 {
@@ -18,4 +282,85 @@ i32 u32NumDigits(u32 x)
   return ((u64)x + table[idx]) >> 32;
 }
 
+i32 u64NumDigits(u64 x)
+{
+    static constexpr u64 pow10[] = {
+        1_u64, 10_u64, 100_u64, 1000_u64, 10000_u64, 100000_u64,
+        1000000_u64, 10000000_u64, 100000000_u64, 1000000000_u64,
+        10000000000_u64, 100000000000_u64, 1000000000000_u64,
+        10000000000000_u64, 100000000000000_u64, 1000000000000000_u64,
+        10000000000000000_u64, 100000000000000000_u64,
+        1000000000000000000_u64, 10000000000000000000_u64,
+    };
+
+    // floor(log10(2) * bit_width) underestimates by at most one digit
+    i32 approx = ((64 - std::countl_zero(x | 1)) * 1233) >> 12;
+    return approx + ((x | 1) >= pow10[approx]);
+}
+
+void fillPattern(void *dst, const void *pattern, i64 pattern_bytes,
+                 i64 num_elems, bool stream,
+                 const ParallelFor *parallel_for)
+{
+    bool simd_pattern = pattern_bytes == 1 || pattern_bytes == 2 ||
+        pattern_bytes == 4 || pattern_bytes == 8 || pattern_bytes == 12 ||
+        pattern_bytes == 16;
+
+    auto fillRange = [&](i64 start, i64 count) {
+        u8 *range_dst = (u8 *)dst + start * pattern_bytes;
+
+        if (!simd_pattern) {
+            for (i64 i = 0; i < count; i++) {
+                memcpy(range_dst + i * pattern_bytes, pattern, pattern_bytes);
+            }
+        } else if (stream) {
+            fillPatternImpl<true>(range_dst, pattern, pattern_bytes, count);
+        } else {
+            fillPatternImpl<false>(range_dst, pattern, pattern_bytes, count);
+        }
+    };
+
+    i64 num_bytes = num_elems * pattern_bytes;
+    if (parallel_for == nullptr || num_bytes < parallelMemOpThreshold) {
+        fillRange(0, num_elems);
+        return;
+    }
+
+    // Each task realigns its own range, so tasks only need to start on
+    // element boundaries.
+    i64 elems_per_task = parallel_task_bytes / pattern_bytes;
+    parallelChunks(*parallel_for, num_elems, elems_per_task, fillRange);
+}
+
+void copyBytesStream(void *dst, const void *src, i64 num_bytes,
+                     const ParallelFor *parallel_for)
+{
+    auto copyRange = [&](i64 start, i64 count) {
+        copyBytesImpl<true>((u8 *)dst + start, (const u8 *)src + start,
+                            count);
+    };
+
+    if (parallel_for == nullptr || num_bytes < parallelMemOpThreshold) {
+        copyRange(0, num_bytes);
+        return;
+    }
+
+    parallelChunks(*parallel_for, num_bytes, parallel_task_bytes, copyRange);
+}
+
+void zeroBytesStream(void *dst, i64 num_bytes,
+                     const ParallelFor *parallel_for)
+{
+    auto zeroRange = [&](i64 start, i64 count) {
+        zeroBytesImpl<true>((u8 *)dst + start, count);
+    };
+
+    if (parallel_for == nullptr || num_bytes < parallelMemOpThreshold) {
+        zeroRange(0, num_bytes);
+        return;
+    }
+
+    parallelChunks(*parallel_for, num_bytes, parallel_task_bytes, zeroRange);
+}
+
 }
@@ -14,6 +14,7 @@
 #ifdef BRT_CXX_MSVC
 #include <bit>
 #endif
+#include <cstring>
 #include <type_traits>
 
 namespace brt {
@@ -75,10 +76,15 @@ constexpr inline u32 u32Hash(u32 x);
 constexpr inline u32 u32mulhi(u32 a, u32 b);
 
 i32 u32NumDigits(u32 x);
+i32 u64NumDigits(u64 x);
 
-inline i64 computeBufferOffsets(const Span<i64> chunk_sizes,
-                                Span<i64> out_offsets,
-                                i64 pow2_alignment);
+// Packs chunks back to back, each starting at a multiple of
+// pow2_alignment. out_offsets receives the offsets of chunks 1 onward
+// (chunk 0 is at offset 0). Returns the total size, rounded up to
+// pow2_alignment.
+constexpr inline i64 computeBufferOffsets(Span<const i64> chunk_sizes,
+                                          Span<i64> out_offsets,
+                                          i64 pow2_alignment);
 
 template <typename T>
 inline void copyN(std::type_identity_t<T> *dst,
@@ -91,6 +97,53 @@ inline void zeroN(std::type_identity_t<T> *ptr, i64 num_elems);
 template <typename T>
 inline void fillN(std::type_identity_t<T> *ptr, T v, i64 num_elems);
 
+// Parallel for loop supplied by the caller's job system. fn must invoke
+// task(task_data, i) for every i in [0, num_tasks) and only return once
+// all invocations have finished.
+struct ParallelFor {
+    void *ctx;
+    void (*fn)(void *ctx, i64 num_tasks,
+               void (*task)(void *task_data, i64 task_idx),
+               void *task_data);
+};
+
+// Runs fn(task_idx) for every task in [0, num_tasks) through parallel_for
+template <typename Fn>
+inline void runParallel(const ParallelFor &parallel_for, i64 num_tasks,
+                        const Fn &fn);
+
+// Buffers at least this large are written with non-temporal stores by the
+// *Stream variants below, so they don't evict the working set from cache.
+inline constexpr i64 streamingStoreThreshold = 4 * 1024 * 1024;
+// Buffers at least this large are split across tasks when a ParallelFor
+// is provided.
+inline constexpr i64 parallelMemOpThreshold = 64 * 1024 * 1024;
+
+template <typename T>
+inline void copyNStream(std::type_identity_t<T> *dst,
+                        const std::type_identity_t<T> *src,
+                        i64 num_elems,
+                        const ParallelFor *parallel_for = nullptr);
+
+template <typename T>
+inline void zeroNStream(std::type_identity_t<T> *ptr, i64 num_elems,
+                        const ParallelFor *parallel_for = nullptr);
+
+template <typename T>
+inline void fillNStream(std::type_identity_t<T> *ptr, T v, i64 num_elems,
+                        const ParallelFor *parallel_for = nullptr);
+
+// Untyped backends for the functions above. fillPattern repeats a
+// pattern_bytes sized pattern num_elems times; patterns of 1, 2, 4, 8, 12
+// and 16 bytes are broadcast into SIMD registers.
+void fillPattern(void *dst, const void *pattern, i64 pattern_bytes,
+                 i64 num_elems, bool stream,
+                 const ParallelFor *parallel_for = nullptr);
+void copyBytesStream(void *dst, const void *src, i64 num_bytes,
+                     const ParallelFor *parallel_for = nullptr);
+void zeroBytesStream(void *dst, i64 num_bytes,
+                     const ParallelFor *parallel_for = nullptr);
+
 }
 
 #if defined(BRT_IS_GPU)
@@ -157,6 +210,36 @@ inline int countl_zero(unsigned long long v)
   return __clzll((long long)v);
 }
 
+inline int countr_zero(unsigned v)
+{
+  return v == 0 ? 32 : __ffs((int)v) - 1;
+}
+
+inline int countr_zero(unsigned long v)
+{
+  return v == 0 ? 64 : __ffsll((long long)v) - 1;
+}
+
+inline int countr_zero(unsigned long long v)
+{
+  return v == 0 ? 64 : __ffsll((long long)v) - 1;
+}
+
+inline int popcount(unsigned v)
+{
+  return __popc(v);
+}
+
+inline int popcount(unsigned long v)
+{
+  return __popcll((unsigned long long)v);
+}
+
+inline int popcount(unsigned long long v)
+{
+  return __popcll(v);
+}
+
 }
 
 #elif defined(BRT_CXX_MSVC)
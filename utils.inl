@@ -203,9 +203,9 @@ constexpr inline u32 u32mulhi(u32 a, u32 b)
     return u32(m >> 32);
 }
 
-inline i64 computeBufferOffsets(const Span<const i64> chunk_sizes,
-                                Span<i64> out_offsets,
-                                i64 pow2_alignment)
+constexpr inline i64 computeBufferOffsets(Span<const i64> chunk_sizes,
+                                          Span<i64> out_offsets,
+                                          i64 pow2_alignment)
 {
     i64 num_total_bytes = chunk_sizes[0];
 
@@ -233,12 +233,80 @@ inline void zeroN(std::type_identity_t<T> *ptr, i64 num_elems)
     memset(ptr, 0, num_elems * sizeof(T));
 }
 
+template <typename T>
+constexpr inline bool isSIMDFillPattern()
+{
+    return std::is_trivially_copyable_v<T> &&
+        (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+         sizeof(T) == 8 || sizeof(T) == 12 || sizeof(T) == 16);
+}
+
 template <typename T>
 inline void fillN(std::type_identity_t<T> *ptr, T v, i64 num_elems)
 {
+    // Small fills aren't worth the call and pattern setup
+    if constexpr (isSIMDFillPattern<T>()) {
+        if (num_elems * (i64)sizeof(T) >= 256) {
+            fillPattern(ptr, &v, sizeof(T), num_elems, false);
+            return;
+        }
+    }
+
     for (i64 i = 0 ; i < num_elems; i++) {
         ptr[i] = v;
     }
 }
 
+template <typename Fn>
+inline void runParallel(const ParallelFor &parallel_for, i64 num_tasks,
+                        const Fn &fn)
+{
+    parallel_for.fn(parallel_for.ctx, num_tasks,
+        [](void *data, i64 task_idx) {
+            (*(const Fn *)data)(task_idx);
+        }, (void *)&fn);
+}
+
+template <typename T>
+inline void copyNStream(std::type_identity_t<T> *dst,
+                        const std::type_identity_t<T> *src,
+                        i64 num_elems,
+                        const ParallelFor *parallel_for)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    i64 num_bytes = num_elems * sizeof(T);
+    if (num_bytes < streamingStoreThreshold) {
+        memcpy(dst, src, num_bytes);
+    } else {
+        copyBytesStream(dst, src, num_bytes, parallel_for);
+    }
+}
+
+template <typename T>
+inline void zeroNStream(std::type_identity_t<T> *ptr, i64 num_elems,
+                        const ParallelFor *parallel_for)
+{
+    i64 num_bytes = num_elems * sizeof(T);
+    if (num_bytes < streamingStoreThreshold) {
+        memset(ptr, 0, num_bytes);
+    } else {
+        zeroBytesStream(ptr, num_bytes, parallel_for);
+    }
+}
+
+template <typename T>
+inline void fillNStream(std::type_identity_t<T> *ptr, T v, i64 num_elems,
+                        const ParallelFor *parallel_for)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    i64 num_bytes = num_elems * sizeof(T);
+    if (num_bytes < streamingStoreThreshold) {
+        fillN<T>(ptr, v, num_elems);
+    } else {
+        fillPattern(ptr, &v, sizeof(T), num_elems, true, parallel_for);
+    }
+}
+
 }